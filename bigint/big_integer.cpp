@@ -1,22 +1,55 @@
 #include "big_integer.h"
 
 #include <algorithm>
+#include <atomic>
+#include <bit>
 #include <cassert>
 #include <charconv>
 #include <cmath>
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <iterator>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <numeric>
 #include <ostream>
 #include <stdexcept>
+#include <thread>
+#include <utility>
+#include <vector>
 
-big_integer::big_integer() : negate(false), limbs(0, 0) {}
+// Векторные ядра для x86-64 выбираются во время выполнения; -DBIG_INTEGER_NO_SIMD оставляет только скалярные.
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__)) && !defined(BIG_INTEGER_NO_SIMD)
+#define BIG_INTEGER_X86_SIMD
+#include <immintrin.h>
+#endif
+
+// Ядра переносов на mulx/adcx/adox - только для 64-битных лимбов (условие то же, что в big_integer.h).
+#if defined(BIG_INTEGER_X86_SIMD) && defined(__SIZEOF_INT128__) &&                                                   \
+    !(defined(BIG_INTEGER_LIMB_BITS) && BIG_INTEGER_LIMB_BITS == 32)
+#define BIG_INTEGER_X86_ADX
+#include <cpuid.h>
+#endif
+
+big_integer::big_integer() : negate(false) {}
 
 big_integer::big_integer(const big_integer& other) = default;
 
+big_integer::big_integer(big_integer&& other) noexcept = default;
+
 big_integer::big_integer(unsigned long long a) : negate(false) {
   set_number(a);
 }
 
 big_integer::big_integer(long long a) : negate(a < 0) {
-  set_number(static_cast<dlimb_t>(a));
+  unsigned long long mag = static_cast<unsigned long long>(a);
+  set_number(a < 0 ? -mag : mag);
 }
 
 big_integer::big_integer(int a) : big_integer(static_cast<long long>(a)) {}
@@ -27,548 +60,3697 @@ big_integer::big_integer(long a) : big_integer(static_cast<long long>(a)) {}
 
 big_integer::big_integer(unsigned long a) : big_integer(static_cast<unsigned long long>(a)) {}
 
-const size_t LIMB_BITS = 32;
-const dlimb_t RADIX = 1LL << LIMB_BITS;
-const limb_t MAX = RADIX - 1;
+const size_t LIMB_BITS = std::numeric_limits<limb_t>::digits;
+const limb_t MAX = std::numeric_limits<limb_t>::max();
 
 // Устанавливает число в массив лимбов.
 void big_integer::set_number(dlimb_t a) {
-  limbs.reserve(size() + 2);
-  limbs.push_back(a % RADIX);
-  a /= RADIX;
-  limbs.push_back(a % RADIX);
+  limbs.push_back(static_cast<limb_t>(a));
+  a >>= LIMB_BITS;
+  limbs.push_back(static_cast<limb_t>(a));
   (*this).normalization();
 }
 
-// Аналог из cpp-ref.
-static bool my_isdigit(char ch) {
-  return std::isdigit(static_cast<unsigned char>(ch));
-}
-
-big_integer::big_integer(const std::string& str) {
-  for (size_t i = 0; i < str.size(); i++) {
-    if (!i) {
-      if (str[i] != '-' && (!my_isdigit(str[i]))) {
-        throw std::invalid_argument("Invalid number - unexpected char at start position");
-      }
-    } else {
-      if (!my_isdigit(str[i])) {
-        throw std::invalid_argument("Invalid number - unexpected chat at position " + std::to_string(i));
-      }
-    }
-  }
-  if (str.empty()) {
-    throw std::invalid_argument("Invalid input - given the empty string.");
-  }
-  if (str.size() == 1 && (str[0] == '-' || str[0] == '+')) {
-    throw std::invalid_argument("Invalid input - no value after the sign.");
-  }
-
-  if (str == "0" || str == "-0") {
-    negate = false;
-  } else {
-    size_t size = str.length();
-    size_t it = (str[0] == '-') ? 1 : 0;
-    negate = str[0] == '-';
-
-    size_t first = (size - it) % 9 + it;
-    uint32_t number = 0;
-    std::from_chars(str.data() + it, str.data() + first, number);
-
-    *this = number;
-    for (it = first; it < size; it += 9) {
-      mul_small(*this, 1000000000);
-      std::from_chars(str.data() + it, str.data() + it + 9, number);
-      *this += number;
-    }
-    if (str[0] == '-') {
-      get_negate(true);
-    }
-  }
-}
-
 limb_t big_integer::get(std::size_t i) const {
-  return (i < limbs.size()) ? limbs[i] : get_filler();
+  return (i < limbs.size()) ? limbs[i] : 0;
 }
 
 std::size_t big_integer::size() const {
   return limbs.size();
 }
 
+// Число хранится как знак и модуль, поэтому модуль и противоположное берутся без прохода по лимбам.
+// Дополнительный код появляется только внутри битовых операций.
+
 // Взять модуль от бигинта.
-void big_integer::get_absolute(bool normalize) {
-  if (negate) {
-    get_negate(normalize);
-  }
+void big_integer::get_absolute(bool) {
+  negate = false;
 }
 
 // Взять противоположное.
-void big_integer::get_negate(bool normalize) {
-  for (limb_t& i : limbs) {
-    i ^= MAX;
-  }
-  negate = !negate;
-  add_sub_small(*this, 1, false, normalize);
+void big_integer::get_negate(bool) {
+  negate = !negate && !limbs.empty();
 }
 
-// Нормализация (удаление лишних нулей).
+// Нормализация (удаление лишних нулей), у нуля знак всегда положительный.
 void big_integer::normalization() {
-  while (!limbs.empty() && limbs.back() == get_filler()) {
+  while (!limbs.empty() && limbs.back() == 0) {
     limbs.pop_back();
   }
-}
-
-// Для заполнения числа нулями/MAX в зависимости от знака.
-limb_t big_integer::get_filler() const {
-  return (negate) ? MAX : 0;
+  if (limbs.empty()) {
+    negate = false;
+  }
 }
 
 // Длинное сложение и вычитание.
-void big_integer::add_sub(big_integer& a, const big_integer& b, bool normalize, bool sub) {
-  std::size_t new_size = std::max(a.size(), b.size()) + 1;
-  a.limbs.resize(new_size, a.get_filler());
-  dlimb_t carry = 0;
-  if (sub) {
-    carry++;
-  }
-
-  for (std::size_t i = 0; i < new_size; i++) {
-    dlimb_t tmp = (sub) ? carry + a.get(i) + ~(b.get(i)) : carry + a.get(i) + (b.get(i));
-    a.limbs[i] = static_cast<limb_t>(tmp);
-    carry = tmp >> LIMB_BITS;
-  }
-  a.negate = a.limbs.back() & LIMB_BITS;
-  if (normalize) {
-    a.normalization();
+void big_integer::add_sub(big_integer& a, const big_integer& b, bool sub) {
+  if (&a == &b) {
+    big_integer copy(b);
+    add_sub_mag(a, std::as_const(copy.limbs).data(), copy.size(), b.negate ^ sub);
+  } else {
+    add_sub_mag(a, std::as_const(b.limbs).data(), b.size(), b.negate ^ sub);
   }
 }
 
-// Короткое.
-void big_integer::add_sub_small(big_integer& a, const limb_t v, bool bnegate, bool normalize) {
-  std::size_t new_size = a.size() + 1;
-  a.limbs.resize(new_size, a.get_filler());
-  dlimb_t res = 0;
-
-  for (std::size_t i = 0; i < new_size; i++) {
-    res += static_cast<dlimb_t>(a.get(i)) + ((i < 1) ? v : (bnegate ? MAX : 0));
-    a.limbs[i] = static_cast<limb_t>(res % RADIX);
-    res >>= LIMB_BITS;
-  }
-  a.negate ^= (res) ^ bnegate;
-
-  if (normalize) {
-    a.normalization();
+// Короткое: a += v (sub: a -= v) для v < β.
+void big_integer::add_sub_small(big_integer& a, const limb_t v, bool sub) {
+  if (a.negate != sub && !a.limbs.empty() && (a.size() > 1 || a.limbs[0] >= v)) {
+    // Модуль уменьшается и остаётся неотрицательным.
+    limb_t* al = a.limbs.data();
+    limb_t borrow = v;
+    for (size_t i = 0; i < a.size() && borrow != 0; i++) {
+      limb_t x = al[i];
+      al[i] = x - borrow;
+      borrow = (x < borrow);
+    }
+  } else if (a.negate != sub && !a.limbs.empty()) {
+    // |a| < v: знак меняется.
+    a.limbs[0] = v - a.limbs[0];
+    a.negate = sub;
+  } else {
+    if (a.limbs.empty()) {
+      a.negate = sub;
+    }
+    a.limbs.push_back(0);
+    limb_t* al = a.limbs.data();
+    limb_t carry = v;
+    for (size_t i = 0; i < a.size() && carry != 0; i++) {
+      al[i] += carry;
+      carry = (al[i] < carry);
+    }
   }
+  a.normalization();
 }
 
 big_integer& big_integer::operator+=(const big_integer& rhs) {
-  add_sub(*this, rhs, true, false);
+  add_sub(*this, rhs, false);
   return *this;
 }
 
 big_integer& big_integer::operator-=(const big_integer& rhs) {
-  add_sub(*this, rhs, true, true);
+  add_sub(*this, rhs, true);
   return *this;
 }
 
 // Умножение.
 
 void big_integer::mul_small(big_integer& bi, const limb_t v) {
-  bi.limbs.resize(bi.limbs.size() + 1, bi.get_filler());
-  bool neg = bi.negate;
-  bi.get_absolute(true);
-  limb_t cnst = v;
+  bi.limbs.push_back(0);
+  limb_t* bl = bi.limbs.data();
 
   dlimb_t s = 0;
   for (std::size_t i = 0; i < bi.size(); i++) {
-    s += static_cast<dlimb_t>(bi.limbs[i]) * cnst;
-    bi.limbs[i] = static_cast<limb_t>(s);
+    s += static_cast<dlimb_t>(bl[i]) * v;
+    bl[i] = static_cast<limb_t>(s);
     s >>= LIMB_BITS;
   }
-  if (neg) {
-    bi.get_negate(true);
+  bi.normalization();
+}
+
+// Пул буферов лимбов (чисел и временных массивов): в каждом потоке свои списки свободных блоков по классам 2^k байт.
+// Вне арены в классе держится не больше POOL_CACHED_BLOCKS блоков, а всего в потоке - не больше POOL_CACHED_BYTES,
+// остальное возвращается в кучу; внутри арены кэшируется всё и освобождается при выходе из внешней арены.
+
+const size_t POOL_MIN_CLASS = 6;
+const size_t POOL_CLASSES = 48;
+const size_t POOL_CACHED_BLOCKS = 8;
+const size_t POOL_CACHED_BYTES = size_t(1) << 22;
+
+namespace {
+
+struct scratch_pool {
+  std::vector<void*> free[POOL_CLASSES];
+  size_t free_bytes = 0;
+  size_t arena_depth = 0;
+
+  ~scratch_pool();
+
+  static size_t size_class(size_t bytes) {
+    return std::max<size_t>(POOL_MIN_CLASS, std::bit_width(bytes - 1));
+  }
+
+  bool cached(size_t c) const {
+    return arena_depth > 0 ||
+           (free[c].size() < POOL_CACHED_BLOCKS && free_bytes + (size_t(1) << c) <= POOL_CACHED_BYTES);
   }
-  if (s > 0) {
-    bi.limbs[bi.size() - 1] = s;
+
+  void* allocate(size_t bytes) {
+    size_t c = size_class(bytes);
+    if (free[c].empty()) {
+      return operator new(size_t(1) << c);
+    }
+    void* p = free[c].back();
+    free[c].pop_back();
+    free_bytes -= size_t(1) << c;
+    return p;
   }
-}
 
-void big_integer::mul(big_integer& a, const big_integer& b) {
-  bool neg = a.negate ^ b.negate;
-  std::size_t asize = a.size();
-  a.limbs.resize(a.size() + b.size() + 1, a.get_filler());
-
-  a.get_absolute(false);
-  big_integer b2 = b;
-  b2.get_absolute(false);
-
-  for (size_t i = asize; i > 0; i--) {
-    std::size_t cnst = a.limbs[i - 1];
-    a.limbs[i - 1] = 0;
-    std::size_t j = 0;
-    dlimb_t s_mul = 0;
-    dlimb_t carry = 0;
-    while (j < b.size() || (carry > 0)) {
-      s_mul = static_cast<dlimb_t>(b2.get(j)) * cnst + carry;
-      carry = s_mul / RADIX;
-      dlimb_t to_add = s_mul % RADIX;
-      if (to_add + a.limbs[i - 1 + j] > MAX) {
-        carry++;
+  // Не бросает: если список не удалось расширить, блок уходит в кучу.
+  void deallocate(void* p, size_t bytes) noexcept {
+    size_t c = size_class(bytes);
+    if (cached(c)) {
+      try {
+        free[c].push_back(p);
+        free_bytes += size_t(1) << c;
+        return;
+      } catch (const std::bad_alloc&) {
       }
-      a.limbs[i - 1 + j] = static_cast<limb_t>(to_add + a.limbs[i - 1 + j]);
-      j++;
     }
+    operator delete(p);
   }
 
-  if (neg) {
-    a.get_negate(true);
+  // Возвращает в кучу всё, что не поместилось бы в пул вне арены; предпочтение - мелким классам.
+  void trim() {
+    free_bytes = 0;
+    for (size_t c = 0; c < POOL_CLASSES; c++) {
+      size_t keep = 0;
+      while (keep < std::min(free[c].size(), POOL_CACHED_BLOCKS) &&
+             free_bytes + (size_t(1) << c) <= POOL_CACHED_BYTES) {
+        free_bytes += size_t(1) << c;
+        keep++;
+      }
+      while (free[c].size() > keep) {
+        operator delete(free[c].back());
+        free[c].pop_back();
+      }
+    }
   }
-  a.normalization();
+};
+
+// Буферы, освобождаемые деструкторами других thread_local после смерти пула, идут прямо в кучу.
+thread_local bool scratch_pool_dead = false;
+
+scratch_pool::~scratch_pool() {
+  arena_depth = 0;
+  for (std::vector<void*>& list : free) {
+    for (void* p : list) {
+      operator delete(p);
+    }
+  }
+  scratch_pool_dead = true;
 }
 
-big_integer& big_integer::operator*=(const big_integer& rhs) {
-  mul((*this), rhs);
-  return *this;
+scratch_pool& pool() {
+  thread_local scratch_pool p;
+  return p;
 }
 
-// Деление.
+// Временный массив лимбов из пула потока.
+using limb_buffer = std::vector<limb_t, big_integer_allocator<limb_t>>;
+
+} // namespace
 
-// Аналог "difference" из статьи.
-void big_integer::div_difference(big_integer& a, const big_integer& b) {
-  dlimb_t res = static_cast<dlimb_t>(~b.get(0)) + 1 + a.get(0);
-  dlimb_t carry = res >> LIMB_BITS;
-  a.limbs[0] = static_cast<limb_t>(res);
-  for (std::size_t i = 1; i < b.size(); i++) {
-    res = static_cast<dlimb_t>(a.get(i)) + static_cast<dlimb_t>(~b.get(i)) + carry;
-    a.limbs[i] = static_cast<limb_t>(res % RADIX);
-    carry = res >> LIMB_BITS;
+void* big_integer_pool::allocate(size_t bytes) {
+  if (scratch_pool_dead) {
+    return operator new(bytes);
   }
+  return pool().allocate(bytes);
 }
 
-// Аналог "shift" из статьи.
-void big_integer::shift(big_integer& a) {
-  for (std::size_t j = a.limbs.size() - 1; j > 0; j--) {
-    a.limbs[j] = a.limbs[j - 1];
+void big_integer_pool::deallocate(void* p, size_t bytes) noexcept {
+  if (scratch_pool_dead) {
+    operator delete(p);
+  } else {
+    pool().deallocate(p, bytes);
   }
 }
 
-// Аналог "smaller" из статьи.
-bool big_integer::div_compare(big_integer& a, big_integer& b) {
-  for (size_t i = a.limbs.size(); i > 0; i--) {
-    if (a.get(i - 1) != b.get(i - 1)) {
-      return a.get(i - 1) < b.get(i - 1);
-    }
+big_integer_arena::big_integer_arena() {
+  pool().arena_depth++;
+}
+
+big_integer_arena::~big_integer_arena() {
+  scratch_pool& p = pool();
+  if (--p.arena_depth == 0) {
+    p.trim();
   }
-  return false;
 }
 
-// Короткое деление.
-limb_t big_integer::div_small(big_integer& bi, const limb_t v) {
-  if (v == 0) {
-    throw std::invalid_argument("haha no zero division");
+// Пул потоков для параллельного умножения с перехватом работы: у каждого рабочего своя дека задач,
+// у потоков вне пула - общая входная. Поток кладёт подзадачи в конец своей деки и сам берёт оттуда же
+// самые новые - обычно подзадачи той же группы, а свободные рабочие забирают самые старые (крупные)
+// задачи с начала чужих дек. Поток, ждущий свою группу, не спит, а выполняет задачи, поэтому вложенные
+// группы не блокируют друг друга. Параллельно считаются только умножения от PARALLEL_THRESHOLD лимбов.
+
+const size_t PARALLEL_THRESHOLD = 600;
+
+namespace {
+
+class task_pool;
+
+// Пул, которому принадлежит текущий поток, если это рабочий поток, и номер его деки.
+thread_local task_pool* worker_pool = nullptr;
+thread_local size_t worker_queue = 0;
+
+class task_pool {
+public:
+  explicit task_pool(unsigned workers) : queues(workers + 1) {
+    threads.reserve(workers);
+    for (unsigned i = 0; i < workers; i++) {
+      threads.emplace_back([this, i] { work(i + 1); });
+    }
   }
-  limb_t s = 0;
-  dlimb_t cur = 0;
-  size_t i = bi.size();
-  while (i > 0) {
-    cur = (static_cast<dlimb_t>(s) << LIMB_BITS) + bi.limbs[i - 1];
-    bi.limbs[i - 1] = (cur / v);
-    s = (cur % v);
-    i--;
+
+  ~task_pool() {
+    stop = true;
+    notify_all();
+    for (std::thread& t : threads) {
+      t.join();
+    }
   }
-  bi.normalization();
-  return s;
-}
 
-// Получение остатка.
-big_integer big_integer::get_reminder(big_integer& buf, limb_t f) {
-  assert(f != 0);
+  task_pool(const task_pool&) = delete;
+  task_pool& operator=(const task_pool&) = delete;
 
-  big_integer rem = 0;
-  for (size_t i = 1; i < buf.size(); i++) {
-    buf.limbs[i - 1] = buf.limbs[i];
+  // Число потоков вместе с вызывающим.
+  size_t size() const {
+    return threads.size() + 1;
   }
-  buf.limbs.pop_back();
-  rem = buf;
-  rem.normalization();
 
-  div_small(rem, f);
-  return rem;
-}
+  void push(std::atomic<size_t>& pending, std::function<void()> f) {
+    pending++;
+    task_queue& q = queues[own_queue()];
+    {
+      std::lock_guard<std::mutex> lock(q.m);
+      q.tasks.push_back(std::move(f));
+    }
+    queued++;
+    {
+      std::lock_guard<std::mutex> lock(m);
+    }
+    cv.notify_one();
+  }
 
-big_integer big_integer::long_divide(big_integer& a, big_integer& b, bool getRem) {
-  auto back = static_cast<dlimb_t>(b.limbs.back());
-  auto f = static_cast<limb_t>((RADIX / (back + 1)));
+  // Завершение задачи группы; первое исключение группы сохраняется в error.
+  void finish(std::atomic<size_t>& pending, std::exception_ptr& error, std::exception_ptr e) {
+    if (e) {
+      std::lock_guard<std::mutex> lock(m);
+      if (!error) {
+        error = std::move(e);
+      }
+    }
+    pending--;
+    notify_all();
+  }
 
-  size_t asize = a.limbs.size();
-  size_t bsize = b.limbs.size();
+  // Ждёт, пока pending не обнулится, выполняя задачи из своей деки или чужих.
+  void wait(const std::atomic<size_t>& pending) {
+    size_t self = own_queue();
+    while (pending != 0) {
+      if (!run_one(self)) {
+        std::unique_lock<std::mutex> lock(m);
+        cv.wait(lock, [&] { return pending == 0 || queued != 0; });
+      }
+    }
+  }
 
-  big_integer dq;
-  dq.limbs.resize(bsize + 1);
-  big_integer buf;
-  buf.limbs.resize(bsize + 1);
-  big_integer ans;
-  ans.limbs.resize(asize - bsize + 1);
+private:
+  struct task_queue {
+    std::mutex m;
+    std::deque<std::function<void()>> tasks;
+  };
 
-  mul_small(a, f);
-  mul_small(b, f);
-  a.normalization();
-  b.normalization();
+  size_t own_queue() const {
+    return worker_pool == this ? worker_queue : 0;
+  }
 
-  for (size_t i = 0; i <= bsize; i++) {
-    buf.limbs[i] = a.get(asize + i - bsize);
+  // Берёт задачу с конца своей деки, иначе с начала чужой, и выполняет её.
+  bool run_one(size_t self) {
+    std::function<void()> f;
+    for (size_t i = 0; i < queues.size() && !f; i++) {
+      task_queue& q = queues[(self + i) % queues.size()];
+      std::lock_guard<std::mutex> lock(q.m);
+      if (!q.tasks.empty()) {
+        if (i == 0) {
+          f = std::move(q.tasks.back());
+          q.tasks.pop_back();
+        } else {
+          f = std::move(q.tasks.front());
+          q.tasks.pop_front();
+        }
+      }
+    }
+    if (!f) {
+      return false;
+    }
+    queued--;
+    f();
+    return true;
   }
-  for (size_t i = asize - bsize + 1; i > 0; i--) {
-    buf.limbs[0] = a.get(i - 1);
 
-    limb_t qt =
-        std::min(static_cast<dlimb_t>(MAX),
-                 ((static_cast<dlimb_t>(buf.limbs.back()) << LIMB_BITS) + buf.limbs[buf.size() - 2]) / b.limbs.back());
+  void work(size_t self) {
+    worker_pool = this;
+    worker_queue = self;
+    while (true) {
+      if (run_one(self)) {
+        continue;
+      }
+      std::unique_lock<std::mutex> lock(m);
+      cv.wait(lock, [&] { return stop || queued != 0; });
+      if (stop) {
+        return;
+      }
+    }
+  }
 
-    dq = b * qt;
-    while (div_compare(buf, dq)) {
-      qt--;
-      dq = b * qt;
+  // Условия ожидания меняются без m, поэтому перед оповещением m берётся, чтобы не потерять пробуждение.
+  void notify_all() {
+    {
+      std::lock_guard<std::mutex> lock(m);
     }
-    div_difference(buf, dq);
-    shift(buf);
-    ans.limbs[i - 1] = qt;
+    cv.notify_all();
   }
 
-  a = ans;
-  a.normalization();
+  std::vector<task_queue> queues;
+  std::atomic<size_t> queued{0};
+  std::atomic<bool> stop{false};
+  std::mutex m;
+  std::condition_variable cv;
+  std::vector<std::thread> threads;
+};
 
-  if (getRem) {
-    return get_reminder(buf, f);
-  } else {
-    return 0;
+// Группа задач fork-join: run ставит задачу в очередь, wait дожидается всех и пробрасывает
+// первое исключение. Деструктор тоже ждёт, чтобы задачи не пережили захваченные ссылки.
+class task_group {
+public:
+  explicit task_group(task_pool& tp) : tp(tp) {}
+
+  ~task_group() {
+    tp.wait(pending);
   }
-}
 
-// Обнуление массива чисел.
-void big_integer::nullify() {
-  while (!limbs.empty()) {
-    limbs.pop_back();
+  task_group(const task_group&) = delete;
+  task_group& operator=(const task_group&) = delete;
+
+  template <typename F>
+  void run(F f) {
+    tp.push(pending, [this, f] {
+      std::exception_ptr e;
+      try {
+        f();
+      } catch (...) {
+        e = std::current_exception();
+      }
+      tp.finish(pending, error, std::move(e));
+    });
   }
-}
 
-big_integer big_integer::div(big_integer& a, big_integer b, bool getRem) {
-  a.get_absolute(true);
-  b.get_absolute(true);
+  void wait() {
+    tp.wait(pending);
+    if (error) {
+      std::rethrow_exception(std::exchange(error, nullptr));
+    }
+  }
 
-  if (a < b) {
-    big_integer rem = a;
-    a.nullify();
-    return rem;
+private:
+  task_pool& tp;
+  std::atomic<size_t> pending{0};
+  std::exception_ptr error;
+};
+
+std::atomic<unsigned> thread_limit{1};
+std::mutex shared_pool_mutex;
+std::shared_ptr<task_pool> shared_pool;
+
+// Пул для умножения длины n лимбов или nullptr, если считать надо в текущем потоке.
+std::shared_ptr<task_pool> parallel_pool(size_t n) {
+  if (n < PARALLEL_THRESHOLD || thread_limit.load(std::memory_order_relaxed) <= 1) {
+    return nullptr;
   }
-  if (b.limbs.size() == 1) {
-    limb_t res = (div_small(a, b.get(0)));
-    return static_cast<big_integer>(res);
+  if (worker_pool) {
+    // Пул рабочего потока жив, пока его держит внешняя группа, так что ссылка не владеющая.
+    return std::shared_ptr<task_pool>(std::shared_ptr<task_pool>(), worker_pool);
   }
-  return long_divide(a, b, (getRem));
+  std::lock_guard<std::mutex> lock(shared_pool_mutex);
+  return shared_pool;
 }
 
-big_integer& big_integer::operator/=(const big_integer& rhs) {
-  bool neg = (*this).negate ^ rhs.negate;
-  div(*this, rhs, false);
-  if (neg) {
-    get_negate(true);
+// f(lo, hi) по кускам [0, n) длины не меньше grain, куски раздаются пулу; без пула - один вызов.
+template <typename F>
+void parallel_for(task_pool* tp, size_t n, size_t grain, const F& f) {
+  size_t parts = tp ? std::min(n / grain, 4 * tp->size()) : 1;
+  if (parts <= 1) {
+    f(0, n);
+    return;
   }
-  return *this;
+  task_group g(*tp);
+  for (size_t i = 0; i < parts; i++) {
+    size_t lo = n * i / parts;
+    size_t hi = n * (i + 1) / parts;
+    g.run([&f, lo, hi] { f(lo, hi); });
+  }
+  g.wait();
 }
 
-big_integer& big_integer::operator%=(const big_integer& rhs) {
-  bool neg = (*this).negate;
-  *this = div(*this, rhs, true);
-  if (neg) {
-    get_negate(true);
+} // namespace
+
+void set_big_integer_threads(unsigned n) {
+  if (n == 0) {
+    n = std::max(1u, std::thread::hardware_concurrency());
   }
-  return *this;
+  std::shared_ptr<task_pool> old;
+  std::lock_guard<std::mutex> lock(shared_pool_mutex);
+  old = std::move(shared_pool);
+  if (n > 1) {
+    shared_pool = std::make_shared<task_pool>(n - 1);
+  }
+  thread_limit.store(n, std::memory_order_relaxed);
 }
 
-// Выбор булевой функции.
-void big_integer::binary_thing(big_integer& a, const big_integer& b, Booleanic op) {
-  std::size_t n = std::max(a.limbs.size(), b.limbs.size());
-  a.limbs.resize(n, get_filler());
-  for (std::size_t i = 0; i < n; i++) {
-    switch (op) {
-    case Booleanic::AND:
-      a.limbs[i] = a.get(i) & b.get(i);
-      break;
-    case Booleanic::OR:
-      a.limbs[i] = a.get(i) | b.get(i);
-      break;
-    case Booleanic::XOR:
-      a.limbs[i] = a.get(i) ^ b.get(i);
-      break;
-    }
+unsigned big_integer_threads() {
+  return thread_limit.load(std::memory_order_relaxed);
+}
+
+// Низкоуровневые операции над модулями чисел: массивы лимбов, младшие лимбы первыми.
+
+// r = a + b, возвращает перенос. r может совпадать с a или b.
+static limb_t add_n_scalar(limb_t* r, const limb_t* a, const limb_t* b, size_t n) {
+  dlimb_t carry = 0;
+  for (size_t i = 0; i < n; i++) {
+    carry += static_cast<dlimb_t>(a[i]) + b[i];
+    r[i] = static_cast<limb_t>(carry);
+    carry >>= LIMB_BITS;
   }
+  return static_cast<limb_t>(carry);
+}
 
-  switch (op) {
-  case Booleanic::AND:
-    a.negate &= b.negate;
-    break;
-  case Booleanic::OR:
-    a.negate |= b.negate;
-    break;
-  case Booleanic::XOR:
-    a.negate ^= b.negate;
-    break;
+// r = a - b, возвращает заём. r может совпадать с a или b.
+static limb_t sub_n_scalar(limb_t* r, const limb_t* a, const limb_t* b, size_t n) {
+  limb_t borrow = 0;
+  for (size_t i = 0; i < n; i++) {
+    limb_t x = a[i];
+    limb_t y = b[i] + borrow;
+    borrow = (y < borrow) | (x < y);
+    r[i] = x - y;
   }
+  return borrow;
 }
 
-big_integer& big_integer::operator&=(const big_integer& rhs) {
-  binary_thing((*this), rhs, Booleanic::AND);
-  (*this).normalization();
-  return *this;
+// r += a * v, возвращает старший лимб переноса.
+static limb_t addmul_1_scalar(limb_t* r, const limb_t* a, size_t n, limb_t v) {
+  dlimb_t carry = 0;
+  for (size_t i = 0; i < n; i++) {
+    carry += static_cast<dlimb_t>(a[i]) * v + r[i];
+    r[i] = static_cast<limb_t>(carry);
+    carry >>= LIMB_BITS;
+  }
+  return static_cast<limb_t>(carry);
 }
 
-big_integer& big_integer::operator|=(const big_integer& rhs) {
-  binary_thing((*this), rhs, Booleanic::OR);
-  (*this).normalization();
-  return *this;
+// r = a * v, возвращает старший лимб.
+static limb_t mul_1_scalar(limb_t* r, const limb_t* a, size_t n, limb_t v) {
+  dlimb_t carry = 0;
+  for (size_t i = 0; i < n; i++) {
+    carry += static_cast<dlimb_t>(a[i]) * v;
+    r[i] = static_cast<limb_t>(carry);
+    carry >>= LIMB_BITS;
+  }
+  return static_cast<limb_t>(carry);
 }
 
-big_integer& big_integer::operator^=(const big_integer& rhs) {
-  binary_thing((*this), rhs, Booleanic::XOR);
-  (*this).normalization();
-  return *this;
+// Школьное умножение строками mul_1 / addmul_1: r[0, an + bn) = a * b. r не пересекается с a и b.
+template <limb_t (*MUL_1)(limb_t*, const limb_t*, size_t, limb_t), limb_t (*ADDMUL_1)(limb_t*, const limb_t*, size_t, limb_t)>
+static void mul_basecase_rows(limb_t* r, const limb_t* a, size_t an, const limb_t* b, size_t bn) {
+  r[an] = MUL_1(r, a, an, b[0]);
+  for (size_t j = 1; j < bn; j++) {
+    r[an + j] = ADDMUL_1(r + j, a, an, b[j]);
+  }
 }
 
-big_integer& big_integer::operator<<=(int rhs) {
-  limb_t sdv = rhs % LIMB_BITS;
-  limb_t s = 0;
-  limbs.reserve(size() + 1);
+// Ядра низкого уровня: скалярные версии, AVX2/AVX-512 для побитовых операций и сравнения, ADX/BMI2 для
+// цепочек переносов; выбор по процессору при первом вызове.
+// В r OP= (b ^ flip) маска flip - 0 или MAX, так правый операнд берётся в обратном коде без отдельного прохода.
 
-  if (sdv != 0) {
-    for (limb_t& limb : limbs) {
-      dlimb_t temp = (static_cast<dlimb_t>(limb) << sdv) + s;
-      s = static_cast<limb_t>(temp >> LIMB_BITS);
-      limb = static_cast<limb_t>(temp);
-    }
-    limbs.push_back(((negate ? MAX : 0) << sdv) + s);
+enum class bit_op {
+  AND,
+  OR,
+  XOR
+};
+
+template <bit_op OP>
+static limb_t apply_bit_op(limb_t x, limb_t y) {
+  if constexpr (OP == bit_op::AND) {
+    return x & y;
+  } else if constexpr (OP == bit_op::OR) {
+    return x | y;
+  } else {
+    return x ^ y;
   }
-  limbs.insert(limbs.begin(), rhs / LIMB_BITS, 0);
-  normalization();
-  return *this;
 }
 
-big_integer& big_integer::operator>>=(int rhs) {
-  limbs.reserve(size() + 1);
-  limbs.erase(limbs.begin(),
-              limbs.begin() + std::min(static_cast<int>(limbs.size()), rhs / static_cast<int>(LIMB_BITS)));
-  if (limbs.empty()) {
-    limbs.push_back(0);
-    (*this).normalization();
-    return *this;
+template <bit_op OP>
+static void bitwise_n_scalar(limb_t* r, const limb_t* b, size_t n, limb_t flip) {
+  for (size_t i = 0; i < n; i++) {
+    r[i] = apply_bit_op<OP>(r[i], b[i] ^ flip);
   }
-  if (negate) {
-    limbs.push_back(MAX);
+}
+
+static void not_n_scalar(limb_t* r, size_t n) {
+  for (size_t i = 0; i < n; i++) {
+    r[i] = ~r[i];
   }
-  rhs %= LIMB_BITS;
-  dlimb_t s = 0;
-  if (rhs != 0) {
-    for (std::size_t i = limbs.size(); i > 0; i--) {
-      dlimb_t tmp = (static_cast<dlimb_t>(limbs[i - 1]) << (LIMB_BITS - rhs)) + s;
-      s = tmp << LIMB_BITS;
-      limbs[i - 1] = static_cast<limb_t>(tmp >> LIMB_BITS);
+}
+
+// Сравнение чисел одной длины со старших лимбов.
+static int cmp_n_scalar(const limb_t* a, const limb_t* b, size_t n) {
+  for (size_t i = n; i > 0; i--) {
+    if (a[i - 1] != b[i - 1]) {
+      return a[i - 1] < b[i - 1] ? -1 : 1;
     }
   }
-  if (negate) {
-    limbs.pop_back();
-  }
-  (*this).normalization();
-  return *this;
+  return 0;
 }
 
-big_integer big_integer::operator+() const {
-  return *this;
-}
+#ifdef BIG_INTEGER_X86_SIMD
 
-big_integer big_integer::operator-() const {
-  return ~(*this) + 1;
-}
+const size_t AVX2_LIMBS = 32 / sizeof(limb_t);
+const size_t AVX512_LIMBS = 64 / sizeof(limb_t);
 
-big_integer big_integer::operator~() const {
-  big_integer res(*this);
-  for (limb_t& i : res.limbs) {
-    i ^= MAX;
+template <bit_op OP>
+__attribute__((target("avx2"))) static void bitwise_n_avx2(limb_t* r, const limb_t* b, size_t n, limb_t flip) {
+  const __m256i f = _mm256_set1_epi8(static_cast<char>(flip));
+  size_t i = 0;
+  for (; i + AVX2_LIMBS <= n; i += AVX2_LIMBS) {
+    __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(r + i));
+    __m256i y = _mm256_xor_si256(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(b + i)), f);
+    if constexpr (OP == bit_op::AND) {
+      x = _mm256_and_si256(x, y);
+    } else if constexpr (OP == bit_op::OR) {
+      x = _mm256_or_si256(x, y);
+    } else {
+      x = _mm256_xor_si256(x, y);
+    }
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(r + i), x);
   }
-  res.negate = !negate;
-  return res;
+  bitwise_n_scalar<OP>(r + i, b + i, n - i, flip);
 }
 
-big_integer& big_integer::operator=(const big_integer& other) {
-  big_integer copy = other;
-  std::swap((*this).limbs, copy.limbs);
-  std::swap((*this).negate, copy.negate);
-  return *this;
+__attribute__((target("avx2"))) static void not_n_avx2(limb_t* r, size_t n) {
+  const __m256i ones = _mm256_set1_epi8(-1);
+  size_t i = 0;
+  for (; i + AVX2_LIMBS <= n; i += AVX2_LIMBS) {
+    __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(r + i));
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(r + i), _mm256_xor_si256(x, ones));
+  }
+  not_n_scalar(r + i, n - i);
 }
 
-big_integer& big_integer::operator++() {
-  add_sub_small(*this, 1, false, true);
-  return *this;
+// Первый со старшего конца различающийся байт блока даёт номер различающегося лимба.
+__attribute__((target("avx2"))) static int cmp_n_avx2(const limb_t* a, const limb_t* b, size_t n) {
+  size_t i = n;
+  while (i >= AVX2_LIMBS) {
+    i -= AVX2_LIMBS;
+    __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + i));
+    __m256i y = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b + i));
+    auto diff = ~static_cast<std::uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(x, y)));
+    if (diff != 0) {
+      size_t j = i + (31 - std::countl_zero(diff)) / sizeof(limb_t);
+      return a[j] < b[j] ? -1 : 1;
+    }
+  }
+  return cmp_n_scalar(a, b, i);
 }
 
-big_integer big_integer::operator++(int) {
-  big_integer tmp(*this);
-  add_sub_small(*this, 1, false, true);
-  return tmp;
+template <bit_op OP>
+__attribute__((target("avx512f"))) static void bitwise_n_avx512(limb_t* r, const limb_t* b, size_t n, limb_t flip) {
+  const __m512i f = _mm512_set1_epi32(static_cast<int>(flip));
+  size_t i = 0;
+  for (; i + AVX512_LIMBS <= n; i += AVX512_LIMBS) {
+    __m512i x = _mm512_loadu_si512(r + i);
+    __m512i y = _mm512_xor_si512(_mm512_loadu_si512(b + i), f);
+    if constexpr (OP == bit_op::AND) {
+      x = _mm512_and_si512(x, y);
+    } else if constexpr (OP == bit_op::OR) {
+      x = _mm512_or_si512(x, y);
+    } else {
+      x = _mm512_xor_si512(x, y);
+    }
+    _mm512_storeu_si512(r + i, x);
+  }
+  bitwise_n_scalar<OP>(r + i, b + i, n - i, flip);
 }
 
-big_integer& big_integer::operator--() {
-  add_sub_small(*this, -1, true, true);
-  return *this;
+__attribute__((target("avx512f"))) static void not_n_avx512(limb_t* r, size_t n) {
+  const __m512i ones = _mm512_set1_epi32(-1);
+  size_t i = 0;
+  for (; i + AVX512_LIMBS <= n; i += AVX512_LIMBS) {
+    _mm512_storeu_si512(r + i, _mm512_xor_si512(_mm512_loadu_si512(r + i), ones));
+  }
+  not_n_scalar(r + i, n - i);
 }
 
-big_integer big_integer::operator--(int) {
-  big_integer tmp(*this);
-  add_sub_small(*this, -1, true, true);
-  return tmp;
+__attribute__((target("avx512f"))) static int cmp_n_avx512(const limb_t* a, const limb_t* b, size_t n) {
+  size_t i = n;
+  while (i >= AVX512_LIMBS) {
+    i -= AVX512_LIMBS;
+    __m512i x = _mm512_loadu_si512(a + i);
+    __m512i y = _mm512_loadu_si512(b + i);
+    std::uint32_t diff;
+    if constexpr (LIMB_BITS == 64) {
+      diff = _mm512_cmpneq_epi64_mask(x, y);
+    } else {
+      diff = _mm512_cmpneq_epi32_mask(x, y);
+    }
+    if (diff != 0) {
+      size_t j = i + 31 - std::countl_zero(diff);
+      return a[j] < b[j] ? -1 : 1;
+    }
+  }
+  return cmp_n_scalar(a, b, i);
 }
 
-big_integer operator+(big_integer a, const big_integer& b) {
-  return a += b;
-}
+#endif
 
-big_integer operator-(big_integer a, const big_integer& b) {
-  return a -= b;
-}
+#ifdef BIG_INTEGER_X86_ADX
 
-big_integer operator*(big_integer a, const big_integer& b) {
-  return a *= b;
+// Цепочки переносов на ассемблере: сначала n % 4 одиночных шагов, затем блоки по 4 лимба.
+// Счётчик живёт в rcx и уменьшается через lea, а проверяется jrcxz, чтобы не трогать флаги переноса.
+
+static limb_t add_n_x86(limb_t* r, const limb_t* a, const limb_t* b, size_t n) {
+  size_t count = n % 4;
+  size_t blocks = n / 4;
+  limb_t t;
+  asm volatile("clc\n"
+               "1:\n\t"
+               "jrcxz 2f\n\t"
+               "mov (%[a]), %[t]\n\t"
+               "adc (%[b]), %[t]\n\t"
+               "mov %[t], (%[r])\n\t"
+               "lea 8(%[a]), %[a]\n\t"
+               "lea 8(%[b]), %[b]\n\t"
+               "lea 8(%[r]), %[r]\n\t"
+               "lea -1(%%rcx), %%rcx\n\t"
+               "jmp 1b\n"
+               "2:\n\t"
+               "mov %[blocks], %%rcx\n"
+               "3:\n\t"
+               "jrcxz 4f\n\t"
+               "mov (%[a]), %[t]\n\t"
+               "adc (%[b]), %[t]\n\t"
+               "mov %[t], (%[r])\n\t"
+               "mov 8(%[a]), %[t]\n\t"
+               "adc 8(%[b]), %[t]\n\t"
+               "mov %[t], 8(%[r])\n\t"
+               "mov 16(%[a]), %[t]\n\t"
+               "adc 16(%[b]), %[t]\n\t"
+               "mov %[t], 16(%[r])\n\t"
+               "mov 24(%[a]), %[t]\n\t"
+               "adc 24(%[b]), %[t]\n\t"
+               "mov %[t], 24(%[r])\n\t"
+               "lea 32(%[a]), %[a]\n\t"
+               "lea 32(%[b]), %[b]\n\t"
+               "lea 32(%[r]), %[r]\n\t"
+               "lea -1(%%rcx), %%rcx\n\t"
+               "jmp 3b\n"
+               "4:\n\t"
+               "mov $0, %k[t]\n\t"
+               "adc $0, %k[t]"
+               : [t] "=&r"(t), [r] "+r"(r), [a] "+r"(a), [b] "+r"(b), "+c"(count)
+               : [blocks] "r"(blocks)
+               : "cc", "memory");
+  return t;
 }
 
-big_integer operator/(big_integer a, const big_integer& b) {
-  return a /= b;
+static limb_t sub_n_x86(limb_t* r, const limb_t* a, const limb_t* b, size_t n) {
+  size_t count = n % 4;
+  size_t blocks = n / 4;
+  limb_t t;
+  asm volatile("clc\n"
+               "1:\n\t"
+               "jrcxz 2f\n\t"
+               "mov (%[a]), %[t]\n\t"
+               "sbb (%[b]), %[t]\n\t"
+               "mov %[t], (%[r])\n\t"
+               "lea 8(%[a]), %[a]\n\t"
+               "lea 8(%[b]), %[b]\n\t"
+               "lea 8(%[r]), %[r]\n\t"
+               "lea -1(%%rcx), %%rcx\n\t"
+               "jmp 1b\n"
+               "2:\n\t"
+               "mov %[blocks], %%rcx\n"
+               "3:\n\t"
+               "jrcxz 4f\n\t"
+               "mov (%[a]), %[t]\n\t"
+               "sbb (%[b]), %[t]\n\t"
+               "mov %[t], (%[r])\n\t"
+               "mov 8(%[a]), %[t]\n\t"
+               "sbb 8(%[b]), %[t]\n\t"
+               "mov %[t], 8(%[r])\n\t"
+               "mov 16(%[a]), %[t]\n\t"
+               "sbb 16(%[b]), %[t]\n\t"
+               "mov %[t], 16(%[r])\n\t"
+               "mov 24(%[a]), %[t]\n\t"
+               "sbb 24(%[b]), %[t]\n\t"
+               "mov %[t], 24(%[r])\n\t"
+               "lea 32(%[a]), %[a]\n\t"
+               "lea 32(%[b]), %[b]\n\t"
+               "lea 32(%[r]), %[r]\n\t"
+               "lea -1(%%rcx), %%rcx\n\t"
+               "jmp 3b\n"
+               "4:\n\t"
+               "mov $0, %k[t]\n\t"
+               "adc $0, %k[t]"
+               : [t] "=&r"(t), [r] "+r"(r), [a] "+r"(a), [b] "+r"(b), "+c"(count)
+               : [blocks] "r"(blocks)
+               : "cc", "memory");
+  return t;
 }
 
-big_integer operator%(big_integer a, const big_integer& b) {
-  return a %= b;
+// r += a * v на mulx с двумя независимыми цепочками: adcx (CF) несёт старшие половины произведений,
+// adox (OF) - сложение с r. Обе цепочки сливаются в перенос после цикла.
+static limb_t addmul_1_adx(limb_t* r, const limb_t* a, size_t n, limb_t v) {
+  size_t count = n % 4;
+  size_t blocks = n / 4;
+  limb_t carry = 0;
+  limb_t lo;
+  limb_t hi;
+  asm volatile("xor %k[lo], %k[lo]\n"
+               "1:\n\t"
+               "jrcxz 2f\n\t"
+               "mulx (%[a]), %[lo], %[hi]\n\t"
+               "adcx %[c], %[lo]\n\t"
+               "adox (%[r]), %[lo]\n\t"
+               "mov %[lo], (%[r])\n\t"
+               "mov %[hi], %[c]\n\t"
+               "lea 8(%[a]), %[a]\n\t"
+               "lea 8(%[r]), %[r]\n\t"
+               "lea -1(%%rcx), %%rcx\n\t"
+               "jmp 1b\n"
+               "2:\n\t"
+               "mov %[blocks], %%rcx\n"
+               "3:\n\t"
+               "jrcxz 4f\n\t"
+               "mulx (%[a]), %[lo], %[hi]\n\t"
+               "adcx %[c], %[lo]\n\t"
+               "adox (%[r]), %[lo]\n\t"
+               "mov %[lo], (%[r])\n\t"
+               "mulx 8(%[a]), %[lo], %[c]\n\t"
+               "adcx %[hi], %[lo]\n\t"
+               "adox 8(%[r]), %[lo]\n\t"
+               "mov %[lo], 8(%[r])\n\t"
+               "mulx 16(%[a]), %[lo], %[hi]\n\t"
+               "adcx %[c], %[lo]\n\t"
+               "adox 16(%[r]), %[lo]\n\t"
+               "mov %[lo], 16(%[r])\n\t"
+               "mulx 24(%[a]), %[lo], %[c]\n\t"
+               "adcx %[hi], %[lo]\n\t"
+               "adox 24(%[r]), %[lo]\n\t"
+               "mov %[lo], 24(%[r])\n\t"
+               "lea 32(%[a]), %[a]\n\t"
+               "lea 32(%[r]), %[r]\n\t"
+               "lea -1(%%rcx), %%rcx\n\t"
+               "jmp 3b\n"
+               "4:\n\t"
+               "mov $0, %k[lo]\n\t"
+               "adcx %[lo], %[c]\n\t"
+               "adox %[lo], %[c]"
+               : [c] "+&r"(carry), [lo] "=&r"(lo), [hi] "=&r"(hi), [r] "+r"(r), [a] "+r"(a), "+c"(count)
+               : [blocks] "r"(blocks), "d"(v)
+               : "cc", "memory");
+  return carry;
 }
 
-big_integer operator&(big_integer a, const big_integer& b) {
-  return a &= b;
+// r = a * v: одна цепочка adcx по старшим половинам.
+static limb_t mul_1_adx(limb_t* r, const limb_t* a, size_t n, limb_t v) {
+  size_t count = n % 4;
+  size_t blocks = n / 4;
+  limb_t carry = 0;
+  limb_t lo;
+  limb_t hi;
+  asm volatile("xor %k[lo], %k[lo]\n"
+               "1:\n\t"
+               "jrcxz 2f\n\t"
+               "mulx (%[a]), %[lo], %[hi]\n\t"
+               "adcx %[c], %[lo]\n\t"
+               "mov %[lo], (%[r])\n\t"
+               "mov %[hi], %[c]\n\t"
+               "lea 8(%[a]), %[a]\n\t"
+               "lea 8(%[r]), %[r]\n\t"
+               "lea -1(%%rcx), %%rcx\n\t"
+               "jmp 1b\n"
+               "2:\n\t"
+               "mov %[blocks], %%rcx\n"
+               "3:\n\t"
+               "jrcxz 4f\n\t"
+               "mulx (%[a]), %[lo], %[hi]\n\t"
+               "adcx %[c], %[lo]\n\t"
+               "mov %[lo], (%[r])\n\t"
+               "mulx 8(%[a]), %[lo], %[c]\n\t"
+               "adcx %[hi], %[lo]\n\t"
+               "mov %[lo], 8(%[r])\n\t"
+               "mulx 16(%[a]), %[lo], %[hi]\n\t"
+               "adcx %[c], %[lo]\n\t"
+               "mov %[lo], 16(%[r])\n\t"
+               "mulx 24(%[a]), %[lo], %[c]\n\t"
+               "adcx %[hi], %[lo]\n\t"
+               "mov %[lo], 24(%[r])\n\t"
+               "lea 32(%[a]), %[a]\n\t"
+               "lea 32(%[r]), %[r]\n\t"
+               "lea -1(%%rcx), %%rcx\n\t"
+               "jmp 3b\n"
+               "4:\n\t"
+               "mov $0, %k[lo]\n\t"
+               "adcx %[lo], %[c]"
+               : [c] "+&r"(carry), [lo] "=&r"(lo), [hi] "=&r"(hi), [r] "+r"(r), [a] "+r"(a), "+c"(count)
+               : [blocks] "r"(blocks), "d"(v)
+               : "cc", "memory");
+  return carry;
 }
 
-big_integer operator|(big_integer a, const big_integer& b) {
-  return a |= b;
+static bool cpu_has_adx_bmi2() {
+  unsigned eax, ebx, ecx, edx;
+  if (!__get_cpuid_count(7, 0, &eax, &ebx, &ecx, &edx)) {
+    return false;
+  }
+  return (ebx & bit_BMI2) && (ebx & bit_ADX);
+}
+
+#endif
+
+struct limb_kernels {
+  void (*and_n)(limb_t* r, const limb_t* b, size_t n, limb_t flip);
+  void (*or_n)(limb_t* r, const limb_t* b, size_t n, limb_t flip);
+  void (*xor_n)(limb_t* r, const limb_t* b, size_t n, limb_t flip);
+  void (*not_n)(limb_t* r, size_t n);
+  int (*cmp_n)(const limb_t* a, const limb_t* b, size_t n);
+  limb_t (*add_n)(limb_t* r, const limb_t* a, const limb_t* b, size_t n);
+  limb_t (*sub_n)(limb_t* r, const limb_t* a, const limb_t* b, size_t n);
+  limb_t (*addmul_1)(limb_t* r, const limb_t* a, size_t n, limb_t v);
+  limb_t (*mul_1)(limb_t* r, const limb_t* a, size_t n, limb_t v);
+  void (*mul_basecase)(limb_t* r, const limb_t* a, size_t an, const limb_t* b, size_t bn);
+};
+
+// Побитовые ядра и ядра переносов выбираются независимо: AVX и ADX/BMI2 - разные расширения.
+static limb_kernels select_kernels() {
+  limb_kernels k = {bitwise_n_scalar<bit_op::AND>,
+                    bitwise_n_scalar<bit_op::OR>,
+                    bitwise_n_scalar<bit_op::XOR>,
+                    not_n_scalar,
+                    cmp_n_scalar,
+                    add_n_scalar,
+                    sub_n_scalar,
+                    addmul_1_scalar,
+                    mul_1_scalar,
+                    mul_basecase_rows<mul_1_scalar, addmul_1_scalar>};
+#ifdef BIG_INTEGER_X86_SIMD
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx512f")) {
+    k.and_n = bitwise_n_avx512<bit_op::AND>;
+    k.or_n = bitwise_n_avx512<bit_op::OR>;
+    k.xor_n = bitwise_n_avx512<bit_op::XOR>;
+    k.not_n = not_n_avx512;
+    k.cmp_n = cmp_n_avx512;
+  } else if (__builtin_cpu_supports("avx2")) {
+    k.and_n = bitwise_n_avx2<bit_op::AND>;
+    k.or_n = bitwise_n_avx2<bit_op::OR>;
+    k.xor_n = bitwise_n_avx2<bit_op::XOR>;
+    k.not_n = not_n_avx2;
+    k.cmp_n = cmp_n_avx2;
+  }
+#endif
+#ifdef BIG_INTEGER_X86_ADX
+  k.add_n = add_n_x86;
+  k.sub_n = sub_n_x86;
+  if (cpu_has_adx_bmi2()) {
+    k.addmul_1 = addmul_1_adx;
+    k.mul_1 = mul_1_adx;
+    k.mul_basecase = mul_basecase_rows<mul_1_adx, addmul_1_adx>;
+  }
+#endif
+  return k;
+}
+
+static const limb_kernels& kernels() {
+  static const limb_kernels k = select_kernels();
+  return k;
+}
+
+// r = a + b, возвращает перенос. r может совпадать с a или b.
+static limb_t add_n(limb_t* r, const limb_t* a, const limb_t* b, size_t n) {
+  return kernels().add_n(r, a, b, n);
+}
+
+// r = a - b, возвращает заём. r может совпадать с a или b.
+static limb_t sub_n(limb_t* r, const limb_t* a, const limb_t* b, size_t n) {
+  return kernels().sub_n(r, a, b, n);
+}
+
+// r += a * v, возвращает старший лимб переноса.
+static limb_t addmul_1(limb_t* r, const limb_t* a, size_t n, limb_t v) {
+  return kernels().addmul_1(r, a, n, v);
+}
+
+// r = a * v, возвращает старший лимб.
+static limb_t mul_1(limb_t* r, const limb_t* a, size_t n, limb_t v) {
+  return kernels().mul_1(r, a, n, v);
+}
+
+// Школьное умножение: r[0, an + bn) = a * b. r не пересекается с a и b.
+static void mul_basecase(limb_t* r, const limb_t* a, size_t an, const limb_t* b, size_t bn) {
+  kernels().mul_basecase(r, a, an, b, bn);
+}
+
+// Прибавить v к числу длины n, возвращает перенос.
+static limb_t add_1(limb_t* r, size_t n, limb_t v) {
+  for (size_t i = 0; i < n && v != 0; i++) {
+    r[i] += v;
+    v = (r[i] < v);
+  }
+  return v;
+}
+
+// Вычесть v из числа длины n, возвращает заём.
+static limb_t sub_1(limb_t* r, size_t n, limb_t v) {
+  for (size_t i = 0; i < n && v != 0; i++) {
+    limb_t x = r[i];
+    r[i] = x - v;
+    v = (x < v);
+  }
+  return v;
+}
+
+// r += a (an <= rn), возвращает перенос из старшего лимба r.
+static limb_t add_to(limb_t* r, size_t rn, const limb_t* a, size_t an) {
+  limb_t carry = add_n(r, r, a, an);
+  return add_1(r + an, rn - an, carry);
+}
+
+// r -= a (an <= rn), возвращает заём из старшего лимба r.
+static limb_t sub_from(limb_t* r, size_t rn, const limb_t* a, size_t an) {
+  limb_t borrow = sub_n(r, r, a, an);
+  return sub_1(r + an, rn - an, borrow);
+}
+
+// Дополнительный код на месте: r = β^n - r. Перенос от +1 доходит только до первого ненулевого лимба,
+// дальше остаётся инверсия.
+static void negate_n(limb_t* r, size_t n) {
+  size_t k = 0;
+  while (k < n && r[k] == 0) {
+    k++;
+  }
+  if (k < n) {
+    r[k] = -r[k];
+    kernels().not_n(r + k + 1, n - k - 1);
+  }
+}
+
+// Сравнение модулей разной длины (старшие нули допускаются).
+static int cmp_mag(const limb_t* a, size_t an, const limb_t* b, size_t bn) {
+  while (an > bn) {
+    if (a[--an] != 0) {
+      return 1;
+    }
+  }
+  while (bn > an) {
+    if (b[--bn] != 0) {
+      return -1;
+    }
+  }
+  return kernels().cmp_n(a, b, an);
+}
+
+// r -= a * v, возвращает старший лимб заёма.
+static limb_t submul_1(limb_t* r, const limb_t* a, size_t n, limb_t v) {
+  dlimb_t carry = 0;
+  for (size_t i = 0; i < n; i++) {
+    carry += static_cast<dlimb_t>(a[i]) * v;
+    limb_t lo = static_cast<limb_t>(carry);
+    carry >>= LIMB_BITS;
+    carry += (r[i] < lo);
+    r[i] -= lo;
+  }
+  return static_cast<limb_t>(carry);
+}
+
+// Точное деление на 3 (остаток гарантированно нулевой).
+static void divexact_by3(limb_t* r, size_t n) {
+  dlimb_t rem = 0;
+  for (size_t i = n; i > 0; i--) {
+    dlimb_t cur = (rem << LIMB_BITS) | r[i - 1];
+    r[i - 1] = static_cast<limb_t>(cur / 3);
+    rem = cur % 3;
+  }
+  assert(rem == 0);
+}
+
+// Сдвиг вправо на один бит.
+static void rshift_1(limb_t* r, size_t n) {
+  for (size_t i = 0; i < n; i++) {
+    r[i] = (r[i] >> 1) | ((i + 1 < n) ? (r[i + 1] << (LIMB_BITS - 1)) : 0);
+  }
+}
+
+// Сдвиг влево на s бит (0 < s < LIMB_BITS), возвращает вытесненные биты.
+// Идёт со старших лимбов, поэтому r может лежать не ниже a (сдвиг на месте со смещением вверх).
+static limb_t lshift(limb_t* r, const limb_t* a, size_t n, unsigned s) {
+  if (n == 0) {
+    return 0;
+  }
+  limb_t out = a[n - 1] >> (LIMB_BITS - s);
+  for (size_t i = n - 1; i > 0; i--) {
+    r[i] = (a[i] << s) | (a[i - 1] >> (LIMB_BITS - s));
+  }
+  r[0] = a[0] << s;
+  return out;
+}
+
+// Сдвиг вправо на s бит (0 < s < LIMB_BITS). Идёт с младших лимбов, r может лежать не выше a.
+static void rshift(limb_t* r, const limb_t* a, size_t n, unsigned s) {
+  for (size_t i = 0; i < n; i++) {
+    r[i] = (a[i] >> s) | ((i + 1 < n) ? (a[i + 1] << (LIMB_BITS - s)) : 0);
+  }
+}
+
+// Квадрат школьным методом: r[0, 2n) = a^2. Каждое a[i] * a[j] при i < j считается один раз,
+// сумма удваивается сдвигом, затем прибавляется диагональ a[i]^2.
+static void sqr_basecase(limb_t* r, const limb_t* a, size_t n) {
+  std::fill(r, r + 2 * n, 0);
+  for (size_t i = 0; i + 1 < n; i++) {
+    r[i + n] = addmul_1(r + 2 * i + 1, a + i + 1, n - i - 1, a[i]);
+  }
+  lshift(r, r, 2 * n, 1);
+  limb_t carry = 0;
+  for (size_t i = 0; i < n; i++) {
+    dlimb_t sq = static_cast<dlimb_t>(a[i]) * a[i];
+    dlimb_t lo = static_cast<dlimb_t>(r[2 * i]) + static_cast<limb_t>(sq) + carry;
+    r[2 * i] = static_cast<limb_t>(lo);
+    dlimb_t hi = static_cast<dlimb_t>(r[2 * i + 1]) + static_cast<limb_t>(sq >> LIMB_BITS) + (lo >> LIMB_BITS);
+    r[2 * i + 1] = static_cast<limb_t>(hi);
+    carry = static_cast<limb_t>(hi >> LIMB_BITS);
+  }
+}
+
+const size_t KARATSUBA_THRESHOLD = 32;
+const size_t TOOM3_THRESHOLD = 160;
+const size_t NTT_THRESHOLD = 2500;
+
+static void mul_n(limb_t* r, const limb_t* a, const limb_t* b, size_t n, limb_t* scratch);
+static void mul_mag(limb_t* r, const limb_t* a, size_t an, const limb_t* b, size_t bn);
+
+// Размер буфера, необходимого mul_n для операндов длины n.
+static size_t mul_n_itch(size_t n) {
+  if (n < KARATSUBA_THRESHOLD || n >= TOOM3_THRESHOLD) {
+    return 0;
+  }
+  size_t h = n - n / 2;
+  return 6 * h + 1 + mul_n_itch(h);
+}
+
+// Карацуба: r[0, 2n) = a * b, вариант с разностями |a1 - a0| * |b1 - b0|.
+// При a == b все три произведения - квадраты.
+static void karatsuba(limb_t* r, const limb_t* a, const limb_t* b, size_t n, limb_t* scratch) {
+  size_t l = n / 2;
+  size_t h = n - l;
+  limb_t* da = scratch;
+  limb_t* db = da + h;
+  limb_t* zm = db + h;
+  limb_t* t = zm + 2 * h;
+  limb_t* next = t + 2 * h + 1;
+
+  // da = |a1 - a0|, db = |b1 - b0|, mid_neg - знак произведения (a1 - a0) * (b0 - b1).
+  bool mid_neg = false;
+  std::fill(da, da + 2 * h, 0);
+  std::copy(a, a + l, da);
+  if (cmp_mag(a + l, h, a, l) >= 0) {
+    sub_n(da, a + l, da, h);
+  } else {
+    sub_n(da, da, a + l, h);
+    mid_neg = true;
+  }
+  if (a == b) {
+    db = da;
+    mid_neg = false;
+  } else {
+    std::copy(b, b + l, db);
+    if (cmp_mag(b + l, h, b, l) >= 0) {
+      sub_n(db, b + l, db, h);
+    } else {
+      sub_n(db, db, b + l, h);
+      mid_neg = !mid_neg;
+    }
+  }
+
+  mul_n(r, a, b, l, next);
+  mul_n(r + 2 * l, a + l, b + l, h, next);
+  mul_n(zm, da, db, h, next);
+
+  // t = z0 + z2 -+ zm, результат неотрицателен и равен a0 * b1 + a1 * b0.
+  std::copy(r + 2 * l, r + 2 * n, t);
+  t[2 * h] = 0;
+  add_to(t, 2 * h + 1, r, 2 * l);
+  if (mid_neg) {
+    add_to(t, 2 * h + 1, zm, 2 * h);
+  } else {
+    sub_from(t, 2 * h + 1, zm, 2 * h);
+  }
+  size_t tn = std::min(2 * h + 1, 2 * n - l);
+  [[maybe_unused]] limb_t carry = add_to(r + l, 2 * n - l, t, tn);
+  assert(carry == 0);
+}
+
+// Toom-Cook 3: r[0, 2n) = a * b. Точки 0, 1, -1, 2, бесконечность. При a == b значения в точках
+// считаются один раз, и все пять произведений - квадраты.
+static void toom3(limb_t* r, const limb_t* a, const limb_t* b, size_t n) {
+  size_t k = (n + 2) / 3;
+  size_t s = n - 2 * k;
+  size_t pn = k + 1;
+  const limb_t* a0 = a;
+  const limb_t* a1 = a + k;
+  const limb_t* a2 = a + 2 * k;
+  const limb_t* b0 = b;
+  const limb_t* b1 = b + k;
+  const limb_t* b2 = b + 2 * k;
+
+  // Значения многочленов в точках 1, -1 и 2 (длины k + 1).
+  limb_buffer buf(6 * pn, 0);
+  limb_t* ap1 = buf.data();
+  limb_t* am1 = ap1 + pn;
+  limb_t* ap2 = am1 + pn;
+  limb_t* bp1 = ap2 + pn;
+  limb_t* bm1 = bp1 + pn;
+  limb_t* bp2 = bm1 + pn;
+
+  auto evaluate = [&](const limb_t* x0, const limb_t* x1, const limb_t* x2, limb_t* p1, limb_t* m1, limb_t* p2) {
+    // m1 = x0 + x2, p1 = m1 + x1
+    std::copy(x0, x0 + k, m1);
+    m1[k] = add_to(m1, k, x2, s);
+    std::copy(m1, m1 + pn, p1);
+    add_to(p1, pn, x1, k);
+    bool neg = cmp_mag(m1, pn, x1, k) < 0;
+    if (neg) {
+      sub_n(m1, x1, m1, k);
+    } else {
+      sub_from(m1, pn, x1, k);
+    }
+    // p2 = x0 + 2 * (x1 + 2 * x2)
+    std::fill(p2, p2 + pn, 0);
+    std::copy(x2, x2 + s, p2);
+    p2[s] = lshift(p2, p2, s, 1);
+    add_to(p2, pn, x1, k);
+    lshift(p2, p2, pn, 1);
+    add_to(p2, pn, x0, k);
+    return neg;
+  };
+  bool am1_neg = evaluate(a0, a1, a2, ap1, am1, ap2);
+  bool bm1_neg = am1_neg;
+  if (a == b) {
+    bp1 = ap1;
+    bm1 = am1;
+    bp2 = ap2;
+  } else {
+    bm1_neg = evaluate(b0, b1, b2, bp1, bm1, bp2);
+  }
+
+  // Произведения в точках, длины 2k + 2.
+  size_t rn = 2 * pn;
+  limb_buffer prod(3 * rn);
+  limb_t* r1 = prod.data();
+  limb_t* rm1 = r1 + rn;
+  limb_t* r2 = rm1 + rn;
+  // c0 = a0 * b0 и c4 = a2 * b2 сразу на свои места в r.
+  std::fill(r + 2 * k, r + 4 * k, 0);
+  if (std::shared_ptr<task_pool> tp = parallel_pool(n)) {
+    // Пять независимых произведений, у каждой задачи свой буфер.
+    auto product = [](limb_t* res, const limb_t* x, const limb_t* y, size_t len) {
+      limb_buffer scratch(mul_n_itch(len));
+      mul_n(res, x, y, len, scratch.data());
+    };
+    task_group g(*tp);
+    g.run([=] { product(r1, ap1, bp1, pn); });
+    g.run([=] { product(rm1, am1, bm1, pn); });
+    g.run([=] { product(r2, ap2, bp2, pn); });
+    g.run([=] { mul_mag(r + 4 * k, a2, s, b2, s); });
+    g.run([=] { product(r, a0, b0, k); });
+    g.wait();
+  } else {
+    limb_buffer scratch(std::max(mul_n_itch(pn), mul_n_itch(k)));
+    mul_n(r1, ap1, bp1, pn, scratch.data());
+    mul_n(rm1, am1, bm1, pn, scratch.data());
+    mul_n(r2, ap2, bp2, pn, scratch.data());
+    mul_n(r, a0, b0, k, scratch.data());
+    mul_mag(r + 4 * k, a2, s, b2, s);
+  }
+  bool rm1_neg = am1_neg ^ bm1_neg;
+  const limb_t* c0 = r;
+  const limb_t* c4 = r + 4 * k;
+  size_t c4n = 2 * s;
+
+  // Интерполяция, все промежуточные значения неотрицательны:
+  // t1 = (r1 - rm1) / 2 = c1 + c3, t2 = (r1 + rm1) / 2 = c0 + c2 + c4,
+  // u = (r2 - c0 - 4 * c2 - 16 * c4) / 2 = c1 + 4 * c3.
+  limb_buffer tmp(r1, r1 + rn);
+  add_n(r1, r1, rm1, rn);
+  sub_n(rm1, tmp.data(), rm1, rn);
+  limb_t* t1 = rm1_neg ? r1 : rm1;
+  limb_t* c2 = rm1_neg ? rm1 : r1;
+  rshift_1(t1, rn);
+  rshift_1(c2, rn);
+  sub_from(c2, rn, c0, 2 * k);
+  sub_from(c2, rn, c4, c4n);
+
+  // u = r2 - c0 - 4 * c2 - 16 * c4
+  limb_t* u = r2;
+  sub_from(u, rn, c0, 2 * k);
+  lshift(tmp.data(), c2, rn, 2);
+  sub_from(u, rn, tmp.data(), rn);
+  std::fill(tmp.begin(), tmp.end(), 0);
+  tmp[c4n] = lshift(tmp.data(), c4, c4n, 4);
+  sub_from(u, rn, tmp.data(), c4n + 1);
+  rshift_1(u, rn);
+  // c3 = (u - t1) / 3, c1 = t1 - c3
+  limb_t* c3 = u;
+  sub_from(c3, rn, t1, rn);
+  divexact_by3(c3, rn);
+  limb_t* c1 = t1;
+  sub_from(c1, rn, c3, rn);
+
+  add_to(r + k, 2 * n - k, c1, std::min(rn, 2 * n - k));
+  add_to(r + 2 * k, 2 * n - 2 * k, c2, std::min(rn, 2 * n - 2 * k));
+  add_to(r + 3 * k, 2 * n - 3 * k, c3, std::min(rn, 2 * n - 3 * k));
+}
+
+#ifdef __SIZEOF_INT128__
+#define BIG_INTEGER_NTT
+
+// Умножение через NTT по трём 62-битным простым модулям с восстановлением по КТО.
+// Операнды режутся на 64-битные слова, свёртка слов длины n не превосходит n * 2^128,
+// что меньше произведения модулей (около 2^183).
+
+namespace {
+
+using word_t = std::uint64_t;
+__extension__ typedef unsigned __int128 dword_t;
+using word_buffer = std::vector<word_t, big_integer_allocator<word_t>>;
+
+// Длина блока NTT, который целиком помещается в L1 и считается одной задачей.
+const size_t NTT_BLOCK = size_t(1) << 12;
+
+// Арифметика по модулю p в форме Монтгомери (R = 2^64), p < 2^62.
+struct ntt_field {
+  word_t p;
+  word_t g;
+  word_t nprime;
+  word_t r2;
+
+  ntt_field(word_t p, word_t g) : p(p), g(g) {
+    word_t inv = p;
+    for (int i = 0; i < 5; i++) {
+      inv *= 2 - p * inv;
+    }
+    nprime = -inv;
+    word_t r = static_cast<word_t>((static_cast<dword_t>(1) << 64) % p);
+    r2 = static_cast<word_t>(static_cast<dword_t>(r) * r % p);
+  }
+
+  word_t mul(word_t a, word_t b) const {
+    dword_t t = static_cast<dword_t>(a) * b;
+    word_t m = static_cast<word_t>(t) * nprime;
+    word_t u = static_cast<word_t>((t + static_cast<dword_t>(m) * p) >> 64);
+    return u >= p ? u - p : u;
+  }
+
+  word_t add(word_t a, word_t b) const {
+    word_t s = a + b;
+    return s >= p ? s - p : s;
+  }
+
+  word_t sub(word_t a, word_t b) const {
+    return a >= b ? a - b : a + p - b;
+  }
+
+  word_t to_mont(word_t a) const {
+    return mul(a, r2);
+  }
+
+  // Обычное (не Монтгомери) возведение в степень.
+  word_t pow(word_t a, word_t e) const {
+    word_t res = 1;
+    while (e > 0) {
+      if (e & 1) {
+        res = static_cast<word_t>(static_cast<dword_t>(res) * a % p);
+      }
+      a = static_cast<word_t>(static_cast<dword_t>(a) * a % p);
+      e >>= 1;
+    }
+    return res;
+  }
+
+  // Корни для преобразования длины n: roots[len + j] = w_{2len}^j в форме Монтгомери.
+  word_buffer roots(size_t n, bool inverse) const {
+    word_buffer res(std::max<size_t>(n, 2));
+    word_t w = pow(g, (p - 1) / n);
+    if (inverse) {
+      w = pow(w, p - 2);
+    }
+    w = to_mont(w);
+    size_t half = n / 2;
+    res[half] = to_mont(1);
+    for (size_t j = 1; j < half; j++) {
+      res[half + j] = mul(res[half + j - 1], w);
+    }
+    for (size_t i = half; i-- > 1;) {
+      res[i] = res[2 * i];
+    }
+    return res;
+  }
+
+  void butterfly_dif(word_t* a, size_t len, size_t lo, size_t hi, const word_t* rt) const {
+    for (size_t t = lo; t < hi; t++) {
+      size_t j = t & (len - 1);
+      size_t i = 2 * t - j;
+      word_t u = a[i];
+      word_t v = a[i + len];
+      a[i] = add(u, v);
+      a[i + len] = mul(sub(u, v), rt[len + j]);
+    }
+  }
+
+  void butterfly_dit(word_t* a, size_t len, size_t lo, size_t hi, const word_t* rt) const {
+    for (size_t t = lo; t < hi; t++) {
+      size_t j = t & (len - 1);
+      size_t i = 2 * t - j;
+      word_t u = a[i];
+      word_t v = mul(a[i + len], rt[len + j]);
+      a[i] = add(u, v);
+      a[i + len] = sub(u, v);
+    }
+  }
+
+  // Прямое преобразование (прореживание по частоте), результат в бит-реверсном порядке.
+  // С пулом стадии длиннее NTT_BLOCK делятся между задачами по бабочкам, после них
+  // блоки длины NTT_BLOCK независимы и досчитываются каждый целиком в одной задаче.
+  void forward(word_t* a, size_t n, const word_t* rt, task_pool* tp) const {
+    size_t len = n / 2;
+    if (tp && n > NTT_BLOCK) {
+      for (; len >= NTT_BLOCK; len >>= 1) {
+        parallel_for(tp, n / 2, NTT_BLOCK / 2, [&](size_t lo, size_t hi) { butterfly_dif(a, len, lo, hi, rt); });
+      }
+      parallel_for(tp, n / NTT_BLOCK, 1, [&](size_t lo, size_t hi) {
+        for (size_t i = lo; i < hi; i++) {
+          forward(a + i * NTT_BLOCK, NTT_BLOCK, rt, nullptr);
+        }
+      });
+      return;
+    }
+    for (; len >= 1; len >>= 1) {
+      for (size_t i = 0; i < n; i += 2 * len) {
+        for (size_t j = 0; j < len; j++) {
+          word_t u = a[i + j];
+          word_t v = a[i + j + len];
+          a[i + j] = add(u, v);
+          a[i + j + len] = mul(sub(u, v), rt[len + j]);
+        }
+      }
+    }
+  }
+
+  // Обратное преобразование (прореживание по времени) без деления на n. Порядок стадий обратный
+  // forward: сначала независимые блоки, потом длинные стадии.
+  void inverse(word_t* a, size_t n, const word_t* rt, task_pool* tp) const {
+    if (tp && n > NTT_BLOCK) {
+      parallel_for(tp, n / NTT_BLOCK, 1, [&](size_t lo, size_t hi) {
+        for (size_t i = lo; i < hi; i++) {
+          inverse(a + i * NTT_BLOCK, NTT_BLOCK, rt, nullptr);
+        }
+      });
+      for (size_t len = NTT_BLOCK; len < n; len <<= 1) {
+        parallel_for(tp, n / 2, NTT_BLOCK / 2, [&](size_t lo, size_t hi) { butterfly_dit(a, len, lo, hi, rt); });
+      }
+      return;
+    }
+    for (size_t len = 1; len < n; len <<= 1) {
+      for (size_t i = 0; i < n; i += 2 * len) {
+        for (size_t j = 0; j < len; j++) {
+          word_t u = a[i + j];
+          word_t v = mul(a[i + j + len], rt[len + j]);
+          a[i + j] = add(u, v);
+          a[i + j + len] = sub(u, v);
+        }
+      }
+    }
+  }
+
+  // Циклическая свёртка по модулю p, результат в fa. fb портится, при fb == fa считается квадрат.
+  void convolve(word_t* fa, word_t* fb, size_t n, task_pool* tp) const {
+    word_buffer rt = roots(n, false);
+    parallel_for(tp, n, NTT_BLOCK, [&](size_t lo, size_t hi) {
+      for (size_t i = lo; i < hi; i++) {
+        fa[i] %= p;
+        fb[i] %= p;
+      }
+    });
+    forward(fa, n, rt.data(), tp);
+    if (fb != fa) {
+      forward(fb, n, rt.data(), tp);
+    }
+    parallel_for(tp, n, NTT_BLOCK, [&](size_t lo, size_t hi) {
+      for (size_t i = lo; i < hi; i++) {
+        fa[i] = mul(fa[i], fb[i]);
+      }
+    });
+    rt = roots(n, true);
+    inverse(fa, n, rt.data(), tp);
+    // Поточечное произведение дало лишний множитель R^-1, компенсируем вместе с 1 / n.
+    word_t scale = static_cast<word_t>(static_cast<dword_t>(r2) * pow(n % p, p - 2) % p);
+    parallel_for(tp, n, NTT_BLOCK, [&](size_t lo, size_t hi) {
+      for (size_t i = lo; i < hi; i++) {
+        fa[i] = mul(fa[i], scale);
+      }
+    });
+  }
+};
+
+const ntt_field NTT_PRIMES[3] = {
+    {4179340454199820289ULL, 3},
+    {2485986994308513793ULL, 5},
+    {1945555039024054273ULL, 5},
+};
+
+const size_t LIMBS_PER_WORD = 64 / LIMB_BITS;
+
+word_buffer limbs_to_words(const limb_t* a, size_t an, size_t n) {
+  word_buffer res(n, 0);
+  for (size_t i = 0; i < an; i++) {
+    res[i / LIMBS_PER_WORD] |= static_cast<word_t>(a[i]) << (i % LIMBS_PER_WORD * LIMB_BITS);
+  }
+  return res;
+}
+
+} // namespace
+
+// r[0, an + bn) = a * b через свёртку по трём модулям.
+static void mul_ntt(limb_t* r, const limb_t* a, size_t an, const limb_t* b, size_t bn) {
+  size_t wa = (an + LIMBS_PER_WORD - 1) / LIMBS_PER_WORD;
+  size_t wb = (bn + LIMBS_PER_WORD - 1) / LIMBS_PER_WORD;
+  size_t wn = wa + wb;
+  size_t n = 1;
+  while (n < wn - 1) {
+    n <<= 1;
+  }
+
+  // Свёртки по трём модулям независимы; с пулом они идут параллельно и сами делятся на задачи.
+  std::shared_ptr<task_pool> tp = parallel_pool(bn);
+  word_buffer res[3];
+  auto convolution = [&](size_t k) {
+    if (a == b && an == bn) {
+      NTT_PRIMES[k].convolve(res[k].data(), res[k].data(), n, tp.get());
+    } else {
+      word_buffer fb = limbs_to_words(b, bn, n);
+      NTT_PRIMES[k].convolve(res[k].data(), fb.data(), n, tp.get());
+    }
+  };
+  for (size_t k = 0; k < 3; k++) {
+    res[k] = limbs_to_words(a, an, n);
+  }
+  if (tp) {
+    task_group g(*tp);
+    for (size_t k = 0; k < 3; k++) {
+      g.run([&convolution, k] { convolution(k); });
+    }
+    g.wait();
+  } else {
+    for (size_t k = 0; k < 3; k++) {
+      convolution(k);
+    }
+  }
+
+  // Алгоритм Гарнера: x = t0 + t1 * p0 + t2 * p0 * p1.
+  const word_t p0 = NTT_PRIMES[0].p;
+  const word_t p1 = NTT_PRIMES[1].p;
+  const word_t p2 = NTT_PRIMES[2].p;
+  const word_t inv01 = NTT_PRIMES[1].pow(p0 % p1, p1 - 2);
+  const dword_t p01 = static_cast<dword_t>(p0) * p1;
+  const word_t inv012 = NTT_PRIMES[2].pow(static_cast<word_t>(p01 % p2), p2 - 2);
+  const word_t p01_lo = static_cast<word_t>(p01);
+  const word_t p01_hi = static_cast<word_t>(p01 >> 64);
+
+  word_buffer out(wn, 0);
+  word_t c0 = 0;
+  word_t c1 = 0;
+  word_t c2 = 0;
+  for (size_t i = 0; i < wn; i++) {
+    if (i < wn - 1) {
+      word_t t0 = res[0][i];
+      word_t t1 = static_cast<word_t>(static_cast<dword_t>(res[1][i] + p1 - t0 % p1) * inv01 % p1);
+      dword_t low = t0 + static_cast<dword_t>(t1) * p0;
+      word_t t2 = static_cast<word_t>(static_cast<dword_t>(res[2][i] + p2 - static_cast<word_t>(low % p2)) * inv012 % p2);
+
+      // (c0, c1, c2) += low + t2 * p01
+      dword_t s = static_cast<dword_t>(c0) + static_cast<word_t>(low);
+      c0 = static_cast<word_t>(s);
+      s = (s >> 64) + c1 + static_cast<word_t>(low >> 64);
+      c1 = static_cast<word_t>(s);
+      c2 += static_cast<word_t>(s >> 64);
+
+      dword_t m = static_cast<dword_t>(t2) * p01_lo;
+      s = static_cast<dword_t>(c0) + static_cast<word_t>(m);
+      c0 = static_cast<word_t>(s);
+      s = (s >> 64) + c1 + static_cast<word_t>(m >> 64);
+      dword_t mh = static_cast<dword_t>(t2) * p01_hi;
+      s += static_cast<word_t>(mh);
+      c1 = static_cast<word_t>(s);
+      c2 += static_cast<word_t>(s >> 64) + static_cast<word_t>(mh >> 64);
+    }
+    out[i] = c0;
+    c0 = c1;
+    c1 = c2;
+    c2 = 0;
+  }
+
+  for (size_t i = 0; i < an + bn; i++) {
+    r[i] = static_cast<limb_t>(out[i / LIMBS_PER_WORD] >> (i % LIMBS_PER_WORD * LIMB_BITS));
+  }
+}
+#endif
+
+// Умножение операндов одинаковой длины с выбором алгоритма по размеру, a == b - возведение в квадрат.
+static void mul_n(limb_t* r, const limb_t* a, const limb_t* b, size_t n, limb_t* scratch) {
+  if (n < KARATSUBA_THRESHOLD) {
+    if (a == b) {
+      sqr_basecase(r, a, n);
+    } else {
+      mul_basecase(r, a, n, b, n);
+    }
+  } else if (n < TOOM3_THRESHOLD) {
+    karatsuba(r, a, b, n, scratch);
+#ifdef BIG_INTEGER_NTT
+  } else if (n >= NTT_THRESHOLD) {
+    mul_ntt(r, a, n, b, n);
+#endif
+  } else {
+    toom3(r, a, b, n);
+  }
+}
+
+// r[0, an + bn) = a * b для произвольных длин. Больший операнд режется на куски длины меньшего.
+static void mul_mag(limb_t* r, const limb_t* a, size_t an, const limb_t* b, size_t bn) {
+  if (an < bn) {
+    std::swap(a, b);
+    std::swap(an, bn);
+  }
+  if (bn == 0) {
+    std::fill(r, r + an, 0);
+    return;
+  }
+  if (bn < KARATSUBA_THRESHOLD) {
+    if (a == b && an == bn) {
+      sqr_basecase(r, a, an);
+    } else {
+      mul_basecase(r, a, an, b, bn);
+    }
+    return;
+  }
+#ifdef BIG_INTEGER_NTT
+  if (bn >= NTT_THRESHOLD) {
+    mul_ntt(r, a, an, b, bn);
+    return;
+  }
+#endif
+  if (an == bn) {
+    limb_buffer scratch(mul_n_itch(bn));
+    mul_n(r, a, b, bn, scratch.data());
+    return;
+  }
+  if (std::shared_ptr<task_pool> tp = parallel_pool(an); tp && an >= 2 * bn) {
+    // Куски большего операнда делятся между задачами поровну, каждая задача складывает
+    // свои произведения в отдельный буфер, буферы затем прибавляются к r.
+    size_t chunks = (an + bn - 1) / bn;
+    size_t parts = std::min(chunks, tp->size());
+    std::vector<limb_buffer> acc(parts);
+    std::fill(r, r + an + bn, 0);
+    {
+      task_group g(*tp);
+      for (size_t t = 0; t < parts; t++) {
+        size_t lo = chunks * t / parts * bn;
+        size_t hi = std::min(an, chunks * (t + 1) / parts * bn);
+        acc[t].assign(hi - lo + bn, 0);
+        limb_t* out = acc[t].data();
+        g.run([=] {
+          limb_buffer scratch(mul_n_itch(bn));
+          limb_buffer part(2 * bn);
+          for (size_t i = lo; i < hi; i += bn) {
+            size_t len = std::min(bn, hi - i);
+            if (len == bn) {
+              mul_n(part.data(), a + i, b, bn, scratch.data());
+            } else {
+              mul_mag(part.data(), b, bn, a + i, len);
+            }
+            add_to(out + i - lo, hi - i + bn, part.data(), len + bn);
+          }
+        });
+      }
+      g.wait();
+    }
+    for (size_t t = 0; t < parts; t++) {
+      size_t lo = chunks * t / parts * bn;
+      add_to(r + lo, an + bn - lo, acc[t].data(), acc[t].size());
+    }
+    return;
+  }
+  limb_buffer scratch(mul_n_itch(bn));
+  limb_buffer part(2 * bn);
+  std::fill(r + bn, r + an + bn, 0);
+  mul_n(r, a, b, bn, scratch.data());
+  size_t i = bn;
+  for (; i + bn <= an; i += bn) {
+    mul_n(part.data(), a + i, b, bn, scratch.data());
+    add_to(r + i, an + bn - i, part.data(), 2 * bn);
+  }
+  if (i < an) {
+    mul_mag(part.data(), b, bn, a + i, an - i);
+    add_to(r + i, an + bn - i, part.data(), an - i + bn);
+  }
+}
+
+void big_integer::mul(big_integer& a, const big_integer& b) {
+  if (&a == &b) {
+    sqr(a);
+    return;
+  }
+  limbs_t res;
+  res.resize(a.size() + b.size());
+  mul_mag(res.data(), std::as_const(a.limbs).data(), a.size(), b.limbs.data(), b.size());
+  a.limbs.swap(res);
+  a.negate ^= b.negate;
+  a.normalization();
+}
+
+// Квадрат: операнд не копируется, каждое попарное произведение лимбов считается один раз.
+void big_integer::sqr(big_integer& a) {
+  a.get_absolute(true);
+  limbs_t res;
+  res.resize(2 * a.size());
+  const limb_t* al = std::as_const(a.limbs).data();
+  mul_mag(res.data(), al, a.size(), al, a.size());
+  a.limbs.swap(res);
+  a.normalization();
+}
+
+big_integer square(big_integer a) {
+  a *= a;
+  return a;
+}
+
+big_integer& big_integer::operator*=(const big_integer& rhs) {
+  mul((*this), rhs);
+  return *this;
+}
+
+// a += m (sub: a -= m), где m - модуль длины mn (старшие нули допускаются).
+// Знаки совпадают - модули складываются, иначе из большего модуля вычитается меньший.
+void big_integer::add_sub_mag(big_integer& a, const limb_t* m, size_t mn, bool sub) {
+  while (mn > 0 && m[mn - 1] == 0) {
+    mn--;
+  }
+  size_t an = a.size();
+  if (an == 0 || a.negate == sub) {
+    size_t n = std::max(an, mn) + 1;
+    a.limbs.resize(n);
+    add_to(a.limbs.data(), n, m, mn);
+    a.negate = sub;
+  } else if (cmp_mag(std::as_const(a.limbs).data(), an, m, mn) >= 0) {
+    sub_from(a.limbs.data(), an, m, mn);
+  } else {
+    a.limbs.resize(mn);
+    limb_t* al = a.limbs.data();
+    sub_n(al, m, al, mn);
+    a.negate = sub;
+  }
+  a.normalization();
+}
+
+// a += b * c (sub: a -= b * c) школьным умножением прямо в лимбах a, c - модуль cl длины cn со знаком cneg.
+// При разных знаках строки вычитаются по модулю β^n, и если модуль a оказался меньше произведения,
+// результат один раз переводится из дополнительного кода. b и cl не должны указывать на лимбы a.
+void big_integer::add_product_basecase(big_integer& a, const big_integer& b, const limb_t* cl, size_t cn, bool cneg,
+                                       bool sub) {
+  bool neg = b.negate ^ cneg ^ sub;
+  bool add = a.size() == 0 || a.negate == neg;
+  size_t bn = b.size();
+  size_t n = std::max(a.size(), bn + cn) + 1;
+  a.limbs.resize(n);
+  limb_t* r = a.limbs.data();
+  const limb_t* bl = std::as_const(b.limbs).data();
+  for (size_t j = 0; j < cn; j++) {
+    if (add) {
+      add_1(r + j + bn, n - j - bn, addmul_1(r + j, bl, bn, cl[j]));
+    } else {
+      sub_1(r + j + bn, n - j - bn, submul_1(r + j, bl, bn, cl[j]));
+    }
+  }
+  if (add) {
+    a.negate = neg;
+  } else if (r[n - 1] >> (LIMB_BITS - 1)) {
+    negate_n(r, n);
+    a.negate = neg;
+  }
+  a.normalization();
+}
+
+// a += b * c (sub: a -= b * c). Пока меньший множитель короче порога Карацубы, произведение
+// накапливается прямо в a; иначе произведение модулей считается в буфер и прибавляется одним проходом.
+void big_integer::add_product(big_integer& a, const big_integer& b, const big_integer& c, bool sub) {
+  if (&a == &b || &a == &c) {
+    big_integer b_copy(b);
+    big_integer c_copy(c);
+    add_product(a, b_copy, c_copy, sub);
+    return;
+  }
+  if (b.size() == 0 || c.size() == 0) {
+    return;
+  }
+  if (std::min(b.size(), c.size()) < KARATSUBA_THRESHOLD) {
+    const big_integer& x = b.size() >= c.size() ? b : c;
+    const big_integer& y = b.size() >= c.size() ? c : b;
+    add_product_basecase(a, x, std::as_const(y.limbs).data(), y.size(), y.negate, sub);
+    return;
+  }
+  limb_buffer prod(b.size() + c.size());
+  mul_mag(prod.data(), std::as_const(b.limbs).data(), b.size(), std::as_const(c.limbs).data(), c.size());
+  add_sub_mag(a, prod.data(), prod.size(), sub ^ b.negate ^ c.negate);
+}
+
+// Деление.
+
+// Деление двухлимбового (hi, lo) на d при hi < d: частное помещается в лимб.
+// На x86-64 с 64-битными лимбами - одна инструкция div вместо библиотечного 128-битного деления.
+static limb_t div_2by1(limb_t hi, limb_t lo, limb_t d, limb_t& rem) {
+  assert(hi < d);
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+  if constexpr (LIMB_BITS == 64) {
+    limb_t q;
+    asm("divq %4" : "=a"(q), "=d"(rem) : "a"(lo), "d"(hi), "rm"(d));
+    return q;
+  }
+#endif
+  dlimb_t num = (static_cast<dlimb_t>(hi) << LIMB_BITS) | lo;
+  rem = static_cast<limb_t>(num % d);
+  return static_cast<limb_t>(num / d);
+}
+
+// Короткое деление.
+limb_t big_integer::div_small(big_integer& bi, const limb_t v) {
+  if (v == 0) {
+    throw std::invalid_argument("haha no zero division");
+  }
+  limb_t s = 0;
+  size_t i = bi.size();
+  while (i > 0) {
+    bi.limbs[i - 1] = div_2by1(s, bi.limbs[i - 1], v, s);
+    i--;
+  }
+  bi.normalization();
+  return s;
+}
+
+// Деление Кнута (алгоритм D): q[0, an - dn) = a / d, остаток остаётся в a[0, dn).
+// Делитель нормализован (старший бит d[dn - 1] установлен), dn >= 2.
+// Возвращает старший лимб частного (0 или 1).
+static limb_t divrem_basecase(limb_t* q, limb_t* a, size_t an, const limb_t* d, size_t dn) {
+  size_t qn = an - dn;
+  limb_t qh = cmp_mag(a + qn, dn, d, dn) >= 0;
+  if (qh) {
+    sub_n(a + qn, a + qn, d, dn);
+  }
+  const limb_t d1 = d[dn - 1];
+  const limb_t d0 = d[dn - 2];
+  for (size_t j = qn; j > 0; j--) {
+    limb_t* cur = a + j - 1;
+    dlimb_t qhat;
+    dlimb_t rhat;
+    if (cur[dn] >= d1) {
+      // Остаток от предыдущего шага меньше делителя, поэтому здесь cur[dn] == d1.
+      qhat = MAX;
+      rhat = static_cast<dlimb_t>(cur[dn - 1]) + d1;
+    } else {
+      limb_t r;
+      qhat = div_2by1(cur[dn], cur[dn - 1], d1, r);
+      rhat = r;
+    }
+    while (rhat <= MAX && qhat * d0 > ((rhat << LIMB_BITS) | cur[dn - 2])) {
+      qhat--;
+      rhat += d1;
+    }
+    limb_t borrow = submul_1(cur, d, dn, static_cast<limb_t>(qhat));
+    limb_t top = cur[dn];
+    cur[dn] = top - borrow;
+    if (top < borrow) {
+      qhat--;
+      cur[dn] += add_n(cur, cur, d, dn);
+    }
+    q[j - 1] = static_cast<limb_t>(qhat);
+  }
+  return qh;
+}
+
+const size_t DC_DIV_THRESHOLD = 60;
+const size_t BARRETT_THRESHOLD = 6;
+
+// Рекурсивное деление (RecursiveDivRem из "Modern Computer Arithmetic", алгоритм 1.8):
+// a длины n + m делится на нормализованный b длины n, m <= n.
+// Частное q длины m плюс возвращаемый старший лимб, остаток в a[0, n).
+// Младшая половина делит остаток после старшей, так что половины идут по очереди, а параллельно
+// считаются только умножения на b внутри шагов (от PARALLEL_THRESHOLD лимбов).
+static limb_t divrem_rec(limb_t* q, limb_t* a, const limb_t* b, size_t n, size_t m) {
+  if (m < DC_DIV_THRESHOLD || n - m / 2 < 2) {
+    return divrem_basecase(q, a, n + m, b, n);
+  }
+  size_t k = m / 2;
+  limb_buffer tmp(m);
+
+  // Старшая половина частного: a / β^{2k} делится на b / β^k.
+  limb_t qh = divrem_rec(q + k, a + 2 * k, b + k, n - k, m - k);
+  mul_mag(tmp.data(), q + k, m - k, b, k);
+  limb_t borrow = sub_from(a + k, n, tmp.data(), m);
+  if (qh) {
+    borrow += sub_from(a + m, n + k - m, b, k);
+  }
+  while (borrow > 0) {
+    qh -= sub_1(q + k, m - k, 1);
+    borrow -= add_to(a + k, n, b, n);
+  }
+
+  // Младшая половина частного.
+  limb_t ql = divrem_rec(q, a + k, b + k, n - k, k);
+  qh += add_1(q + k, m - k, ql);
+  mul_mag(tmp.data(), q, k, b, k);
+  borrow = sub_from(a, n, tmp.data(), 2 * k);
+  if (ql) {
+    borrow += sub_from(a + k, n - k, b, k);
+  }
+  while (borrow > 0) {
+    qh -= sub_1(q, m, 1);
+    borrow -= add_to(a, n, b, n);
+  }
+  return qh;
+}
+
+// Деление на нормализованный d: q[0, an - dn) = a / d, остаток остаётся в a[0, dn).
+// Требуется a < β^{an - dn} * d. Длинное частное считается блоками по dn лимбов рекурсивным делением.
+static void divrem_norm(limb_t* q, limb_t* a, size_t an, const limb_t* d, size_t dn) {
+  size_t qn = an - dn;
+  if (dn < DC_DIV_THRESHOLD) {
+    [[maybe_unused]] limb_t qh = divrem_basecase(q, a, an, d, dn);
+    assert(qh == 0);
+    return;
+  }
+  size_t m = qn % dn == 0 ? dn : qn % dn;
+  for (size_t pos = qn - m;; pos -= dn) {
+    [[maybe_unused]] limb_t qh = divrem_rec(q + pos, a + pos, d, dn, m);
+    assert(qh == 0);
+    if (pos == 0) {
+      break;
+    }
+    m = dn;
+  }
+}
+
+// q[0, an - dn + 1) = a / d, r[0, dn) = a % d для модулей, an >= dn >= 2, d[dn - 1] != 0.
+static void divrem_mag(limb_t* q, limb_t* r, const limb_t* a, size_t an, const limb_t* d, size_t dn) {
+  unsigned s = std::countl_zero(d[dn - 1]);
+  limb_buffer na(an + 1);
+  limb_buffer nd(d, d + dn);
+  if (s != 0) {
+    lshift(nd.data(), d, dn, s);
+    na[an] = lshift(na.data(), a, an, s);
+  } else {
+    std::copy(a, a + an, na.begin());
+  }
+
+  divrem_norm(q, na.data(), an + 1, nd.data(), dn);
+
+  if (s != 0) {
+    rshift(r, na.data(), dn, s);
+  } else {
+    std::copy(na.begin(), na.begin() + dn, r);
+  }
+}
+
+// Деление модулей: a становится частным, возвращается остаток (если нужен).
+big_integer big_integer::long_divide(big_integer& a, big_integer& b, bool getRem) {
+  size_t asize = a.limbs.size();
+  size_t bsize = b.limbs.size();
+
+  limbs_t quotient;
+  quotient.resize(asize - bsize + 1);
+  big_integer rem;
+  rem.limbs.resize(bsize);
+  divrem_mag(quotient.data(), rem.limbs.data(), std::as_const(a.limbs).data(), asize, std::as_const(b.limbs).data(),
+             bsize);
+
+  a.limbs.swap(quotient);
+  a.normalization();
+
+  if (getRem) {
+    rem.normalization();
+    return rem;
+  } else {
+    return 0;
+  }
+}
+
+// Обнуление массива чисел.
+void big_integer::nullify() {
+  while (!limbs.empty()) {
+    limbs.pop_back();
+  }
+  negate = false;
+}
+
+big_integer big_integer::div(big_integer& a, big_integer b, bool getRem) {
+  a.get_absolute(true);
+  b.get_absolute(true);
+
+  if (a < b) {
+    big_integer rem = a;
+    a.nullify();
+    return rem;
+  }
+  if (b.limbs.size() == 1) {
+    limb_t res = (div_small(a, b.get(0)));
+    return static_cast<big_integer>(res);
+  }
+  return long_divide(a, b, (getRem));
+}
+
+big_integer& big_integer::operator/=(const big_integer& rhs) {
+  bool neg = (*this).negate ^ rhs.negate;
+  div(*this, rhs, false);
+  if (neg) {
+    get_negate(true);
+  }
+  return *this;
+}
+
+big_integer& big_integer::operator%=(const big_integer& rhs) {
+  bool neg = (*this).negate;
+  *this = div(*this, rhs, true);
+  if (neg) {
+    get_negate(true);
+  }
+  return *this;
+}
+
+// Деление на фиксированный делитель.
+
+// floor(β^{2n} / d) для нормализованного d из n лимбов, итерация Ньютона с удвоением точности:
+// приближение по старшей половине d имеет относительную ошибку 2β^{-h}, после шага - 4β^{-2h},
+// поэтому финальная коррекция делает не больше нескольких шагов.
+static big_integer reciprocal(const big_integer& d, size_t n) {
+  big_integer power = big_integer(1) << static_cast<int>(2 * n * LIMB_BITS);
+  if (n < DC_DIV_THRESHOLD) {
+    return power / d;
+  }
+  size_t h = n - n / 2;
+  int low_bits = static_cast<int>((n - h) * LIMB_BITS);
+  big_integer x = reciprocal(d >> low_bits, h) << low_bits;
+
+  big_integer e = power - d * x;
+  bool neg = e < 0;
+  if (neg) {
+    e = -e;
+  }
+  big_integer step = (x * e) >> static_cast<int>(2 * n * LIMB_BITS);
+  x = neg ? x - step : x + step;
+
+  e = power - d * x;
+  while (e < 0) {
+    --x;
+    e += d;
+  }
+  while (e >= d) {
+    ++x;
+    e -= d;
+  }
+  return x;
+}
+
+// Шаг Барретта: x длины xn, n <= xn <= 2n, x < β^{2n}. q[0, xn - n + 1) = x / d, r[0, n) = x % d.
+// mu = floor(β^{2n} / d) длины n + 1, scratch длины 2 * xn + n + 4.
+static void barrett_step(limb_t* q, limb_t* r, const limb_t* x, size_t xn, const limb_t* d, size_t n, const limb_t* mu,
+                         limb_t* scratch) {
+  size_t qn = xn - n + 1;
+  limb_t* q2 = scratch;
+  limb_t* t = q2 + qn + n + 1;
+  limb_t* rem = t + qn + n;
+
+  // floor(floor(x / β^{n-1}) * mu / β^{n+1}) не больше точного частного и меньше его не более чем на 2.
+  mul_mag(q2, x + n - 1, qn, mu, n + 1);
+  std::copy(q2 + n + 1, q2 + qn + n + 1, q);
+  mul_mag(t, q, qn, d, n);
+  std::fill(rem, rem + n + 1, 0);
+  std::copy(x, x + std::min(xn, n + 1), rem);
+  sub_n(rem, rem, t, n + 1);
+  while (cmp_mag(rem, n + 1, d, n) >= 0) {
+    sub_from(rem, n + 1, d, n);
+    add_1(q, qn, 1);
+  }
+  std::copy(rem, rem + n, r);
+}
+
+big_integer_reducer::big_integer_reducer(const big_integer& divisor) : d(divisor) {
+  if (divisor == 0) {
+    throw std::invalid_argument("Division by zero");
+  }
+  norm = divisor;
+  norm.get_absolute(true);
+  shift = std::countl_zero(norm.limbs.back());
+  norm <<= static_cast<int>(shift);
+  if (norm.size() >= BARRETT_THRESHOLD) {
+    mu = reciprocal(norm, norm.size());
+  }
+}
+
+const big_integer& big_integer_reducer::divisor() const {
+  return d;
+}
+
+big_integer big_integer_reducer::reduce(const big_integer& a) const {
+  big_integer rem;
+  divrem(a, nullptr, &rem);
+  return rem;
+}
+
+big_integer big_integer_reducer::divide(const big_integer& a) const {
+  big_integer quot;
+  divrem(a, &quot, nullptr);
+  return quot;
+}
+
+big_integer big_integer_reducer::divide(const big_integer& a, big_integer& rem) const {
+  big_integer quot;
+  divrem(a, &quot, &rem);
+  return quot;
+}
+
+// Делимое обрабатывается с верхних лимбов блоками: первый блок до 2n лимбов, дальше по n,
+// к каждому блоку приписывается остаток от предыдущего.
+void big_integer_reducer::divrem(const big_integer& a, big_integer* quot, big_integer* rem) const {
+  bool neg = a.negate;
+  big_integer x = a;
+  x.get_absolute(true);
+  x <<= static_cast<int>(shift);
+
+  const size_t n = norm.size();
+  const size_t xn = x.size();
+  const limb_t* dl = norm.limbs.data();
+  const limb_t* ml = mu.limbs.data();
+
+  big_integer::limbs_t q;
+  big_integer::limbs_t r;
+  q.resize(xn + 1);
+  r.resize(n);
+  const big_integer::limbs_t& xl = x.limbs;
+  if (xn < n) {
+    std::copy(xl.begin(), xl.end(), r.begin());
+  } else if (n < BARRETT_THRESHOLD) {
+    // На делителях короче BARRETT_THRESHOLD деление столбиком дешевле двух умножений Барретта,
+    // mu для них не считается, от предвычисления остаётся только нормализация делителя.
+    x.limbs.push_back(0);
+    if (n == 1) {
+      r[0] = big_integer::div_small(x, dl[0]);
+      std::copy(xl.begin(), xl.end(), q.begin());
+    } else {
+      divrem_norm(q.data(), x.limbs.data(), xn + 1, dl, n);
+      std::copy(xl.begin(), xl.begin() + n, r.begin());
+    }
+  } else {
+    limb_buffer scratch(5 * n + 4);
+    limb_buffer block(2 * n);
+    limb_buffer qblock(n + 1);
+    size_t first = std::min(xn, 2 * n);
+    size_t pos = xn - first;
+    barrett_step(q.data() + pos, r.data(), xl.data() + pos, first, dl, n, ml, scratch.data());
+    while (pos > 0) {
+      size_t m = std::min(n, pos);
+      pos -= m;
+      std::copy(xl.begin() + pos, xl.begin() + pos + m, block.begin());
+      std::copy(r.begin(), r.end(), block.begin() + m);
+      barrett_step(qblock.data(), r.data(), block.data(), m + n, dl, n, ml, scratch.data());
+      std::copy(qblock.begin(), qblock.begin() + m, q.begin() + pos);
+    }
+  }
+
+  if (quot) {
+    quot->limbs.swap(q);
+    quot->negate = false;
+    quot->normalization();
+    if (neg != d.negate) {
+      quot->get_negate(true);
+    }
+  }
+  if (rem) {
+    if (shift != 0) {
+      rshift(r.data(), r.data(), n, shift);
+    }
+    rem->limbs.swap(r);
+    rem->negate = false;
+    rem->normalization();
+    if (neg) {
+      rem->get_negate(true);
+    }
+  }
+}
+
+// Арифметика Монтгомери.
+
+// Редукция Монтгомери на месте: t[0, 2n) -> t * β^{-n} mod m в r[0, n). secure - вычитание m без ветвлений.
+// Перенос строки не протягивается по старшим лимбам, а откладывается в top и прибавляется
+// в следующей строке, так что число операций не зависит от данных в обоих режимах.
+static void redc(limb_t* r, limb_t* t, const limb_t* m, size_t n, limb_t minv, bool secure) {
+  limb_t top = 0;
+  for (size_t i = 0; i < n; i++) {
+    limb_t u = t[i] * minv;
+    dlimb_t sum = static_cast<dlimb_t>(addmul_1(t + i, m, n, u)) + t[i + n] + top;
+    t[i + n] = static_cast<limb_t>(sum);
+    top = static_cast<limb_t>(sum >> LIMB_BITS);
+  }
+  limb_t* res = t + n;
+  if (secure) {
+    limb_t* diff = t;
+    limb_t borrow = sub_n(diff, res, m, n);
+    limb_t mask = -static_cast<limb_t>(top | (borrow ^ 1));
+    for (size_t i = 0; i < n; i++) {
+      r[i] = (diff[i] & mask) | (res[i] & ~mask);
+    }
+  } else if (top != 0 || cmp_mag(res, n, m, n) >= 0) {
+    sub_n(r, res, m, n);
+  } else {
+    std::copy(res, res + n, r);
+  }
+}
+
+// Буферы возведения в степень, выделяются один раз на всё возведение.
+struct mont_workspace {
+  const limb_t* m;
+  size_t n;
+  limb_t minv;
+  limb_buffer t;
+  limb_buffer scratch;
+
+  mont_workspace(const limb_t* m, size_t n, limb_t minv)
+      : m(m), n(n), minv(minv), t(2 * n), scratch(mul_n_itch(n)) {}
+
+  // r = a * b * β^{-n} mod m, r может совпадать с a или b.
+  // В режиме secure используется только школьное умножение: в Карацубе есть ветвления по данным.
+  void mul(limb_t* r, const limb_t* a, const limb_t* b, bool secure = false) {
+    if (secure && a == b) {
+      sqr_basecase(t.data(), a, n);
+    } else if (secure) {
+      mul_basecase(t.data(), a, n, b, n);
+    } else {
+      mul_n(t.data(), a, b, n, scratch.data());
+    }
+    redc(r, t.data(), m, n, minv, secure);
+  }
+};
+
+montgomery_context::montgomery_context(const big_integer& modulus) : mod(modulus) {
+  mod.get_absolute(true);
+  if (mod.size() == 0 || (mod.limbs[0] & 1) == 0) {
+    throw std::invalid_argument("Montgomery modulus must be odd");
+  }
+  limb_t inv = mod.limbs[0];
+  for (int i = 0; i < 6; i++) {
+    inv *= 2 - mod.limbs[0] * inv;
+  }
+  minv = -inv;
+  r2 = (big_integer(1) << static_cast<int>(2 * mod.size() * LIMB_BITS)) % mod;
+}
+
+const big_integer& montgomery_context::modulus() const {
+  return mod;
+}
+
+// res[0, n) = a * R mod m.
+void montgomery_context::to_mont(const big_integer& a, limb_t* res) const {
+  size_t n = mod.size();
+  big_integer x = a % mod;
+  if (x < 0) {
+    x += mod;
+  }
+  limb_buffer xl(n, 0);
+  limb_buffer rl(n, 0);
+  std::copy(x.limbs.begin(), x.limbs.end(), xl.begin());
+  std::copy(r2.limbs.begin(), r2.limbs.end(), rl.begin());
+  mont_workspace ws(mod.limbs.data(), n, minv);
+  ws.mul(res, xl.data(), rl.data());
+}
+
+big_integer montgomery_context::from_mont(const limb_t* a, bool secure) const {
+  size_t n = mod.size();
+  limb_buffer t(2 * n, 0);
+  std::copy(a, a + n, t.begin());
+  big_integer res;
+  res.limbs.resize(n);
+  redc(res.limbs.data(), t.data(), mod.limbs.data(), n, minv, secure);
+  res.normalization();
+  return res;
+}
+
+static bool exp_bit(const big_integer::limbs_t& limbs, size_t i) {
+  return (i / LIMB_BITS < limbs.size()) && ((limbs[i / LIMB_BITS] >> (i % LIMB_BITS)) & 1);
+}
+
+big_integer montgomery_context::pow(const big_integer& base, const big_integer& exp) const {
+  if (exp < 0) {
+    throw std::invalid_argument("Negative exponent");
+  }
+  if (mod == 1) {
+    return 0;
+  }
+  size_t n = mod.size();
+  const big_integer::limbs_t& e = exp.limbs;
+  size_t bits = exp.bit_length();
+  size_t k = bits > 671 ? 6 : bits > 239 ? 5 : bits > 79 ? 4 : bits > 23 ? 3 : 1;
+
+  // Нечётные степени g, g^3, ..., g^{2^k - 1}.
+  mont_workspace ws(mod.limbs.data(), n, minv);
+  limb_buffer table(n << (k - 1));
+  limb_buffer g(n);
+  to_mont(base, g.data());
+  std::copy(g.begin(), g.end(), table.begin());
+  if (k > 1) {
+    limb_buffer g2(n);
+    ws.mul(g2.data(), g.data(), g.data());
+    for (size_t i = 1; i < (size_t(1) << (k - 1)); i++) {
+      ws.mul(table.data() + i * n, table.data() + (i - 1) * n, g2.data());
+    }
+  }
+
+  limb_buffer acc(n);
+  to_mont(1, acc.data());
+  for (size_t i = bits; i > 0;) {
+    if (!exp_bit(e, i - 1)) {
+      ws.mul(acc.data(), acc.data(), acc.data());
+      i--;
+      continue;
+    }
+    // Окно [j, i) длины не больше k, заканчивающееся единичным битом.
+    size_t j = i > k ? i - k : 0;
+    while (!exp_bit(e, j)) {
+      j++;
+    }
+    size_t w = 0;
+    for (size_t b = i; b > j; b--) {
+      ws.mul(acc.data(), acc.data(), acc.data());
+      w = (w << 1) | exp_bit(e, b - 1);
+    }
+    ws.mul(acc.data(), acc.data(), table.data() + (w >> 1) * n);
+    i = j;
+  }
+  return from_mont(acc.data());
+}
+
+big_integer montgomery_context::pow_sec(const big_integer& base, const big_integer& exp) const {
+  if (exp < 0) {
+    throw std::invalid_argument("Negative exponent");
+  }
+  if (mod == 1) {
+    return 0;
+  }
+  size_t n = mod.size();
+  const size_t k = 4;
+  const size_t entries = size_t(1) << k;
+  const big_integer::limbs_t& e = exp.limbs;
+
+  // Все степени g^0, ..., g^{2^k - 1}.
+  mont_workspace ws(mod.limbs.data(), n, minv);
+  limb_buffer table(n * entries);
+  limb_buffer one(n);
+  limb_buffer g(n);
+  to_mont(1, one.data());
+  to_mont(base, g.data());
+  std::copy(one.begin(), one.end(), table.begin());
+  std::copy(g.begin(), g.end(), table.begin() + n);
+  for (size_t i = 2; i < entries; i++) {
+    ws.mul(table.data() + i * n, table.data() + (i - 1) * n, g.data(), true);
+  }
+
+  // Окна фиксированной длины по всем лимбам показателя, выборка из таблицы без зависящих от данных адресов.
+  limb_buffer acc = one;
+  limb_buffer sel(n);
+  for (size_t i = e.size() * LIMB_BITS; i > 0; i -= k) {
+    for (size_t b = 0; b < k; b++) {
+      ws.mul(acc.data(), acc.data(), acc.data(), true);
+    }
+    limb_t w = (e[(i - k) / LIMB_BITS] >> ((i - k) % LIMB_BITS)) & (entries - 1);
+    std::fill(sel.begin(), sel.end(), 0);
+    for (size_t t = 0; t < entries; t++) {
+      limb_t mask = -static_cast<limb_t>(t == w);
+      for (size_t l = 0; l < n; l++) {
+        sel[l] |= table[t * n + l] & mask;
+      }
+    }
+    ws.mul(acc.data(), acc.data(), sel.data(), true);
+  }
+  return from_mont(acc.data(), true);
+}
+
+// Для чётного модуля форма Монтгомери неприменима, используется редукция Барретта.
+big_integer powmod(const big_integer& base, const big_integer& exp, const big_integer& mod) {
+  if (mod == 0) {
+    throw std::invalid_argument("Division by zero");
+  }
+  if ((mod & 1) != 0) {
+    return montgomery_context(mod).pow(base, exp);
+  }
+  if (exp < 0) {
+    throw std::invalid_argument("Negative exponent");
+  }
+  big_integer_reducer red(mod);
+  big_integer m = mod < 0 ? -mod : mod;
+  big_integer b = red.reduce(base);
+  if (b < 0) {
+    b += m;
+  }
+  big_integer res = 1;
+  for (big_integer e = exp; e != 0; e >>= 1) {
+    if ((e & 1) != 0) {
+      res = red.reduce(res * b);
+    }
+    b = red.reduce(b * b);
+  }
+  return red.reduce(res);
+}
+
+// Пакетные операции. Числа пакета идут группами по BATCH_LANES соседних чисел: строка лимбов группы
+// занимает одну кэш-линию, и ядра проходят по строкам для всей группы сразу. С AVX-512 группа - это
+// один вектор, умножение идёт по 32-битным цифрам (vpmuludq) столбцами с отложенными переносами.
+// Без AVX-512 сложение и вычитание идут той же раскладкой скалярно, а умножения собирают каждое число
+// подряд и считают обычными ядрами.
+
+const size_t BATCH_LANES = 8;
+
+big_integer_batch::big_integer_batch(size_t count, size_t limbs)
+    : count(count), len(limbs), lanes((count + BATCH_LANES - 1) / BATCH_LANES * BATCH_LANES) {
+  storage.resize(len * lanes);
+}
+
+size_t big_integer_batch::size() const {
+  return count;
+}
+
+size_t big_integer_batch::limbs() const {
+  return len;
+}
+
+size_t big_integer_batch::stride() const {
+  return lanes;
+}
+
+void big_integer_batch::set(size_t j, const big_integer& a) {
+  if (j >= count) {
+    throw std::out_of_range("Batch index out of range");
+  }
+  if (a.negate || a.size() > len) {
+    throw std::invalid_argument("Value does not fit into batch");
+  }
+  limb_t* d = storage.data();
+  for (size_t i = 0; i < len; i++) {
+    d[i * lanes + j] = a.get(i);
+  }
+}
+
+big_integer big_integer_batch::get(size_t j) const {
+  if (j >= count) {
+    throw std::out_of_range("Batch index out of range");
+  }
+  big_integer res;
+  res.limbs.resize(len);
+  for (size_t i = 0; i < len; i++) {
+    res.limbs[i] = storage[i * lanes + j];
+  }
+  res.normalization();
+  return res;
+}
+
+limb_t* big_integer_batch::data() {
+  return storage.data();
+}
+
+const limb_t* big_integer_batch::data() const {
+  return storage.data();
+}
+
+// r = a +- b по модулю β^len для каждого числа.
+template <bool SUB>
+static void batch_add_sub_scalar(limb_t* r, const limb_t* a, const limb_t* b, size_t stride, size_t len) {
+  for (size_t j = 0; j < stride; j += BATCH_LANES) {
+    limb_t carry[BATCH_LANES] = {};
+    for (size_t i = 0; i < len; i++) {
+      for (size_t l = 0; l < BATCH_LANES; l++) {
+        size_t p = i * stride + j + l;
+        if constexpr (SUB) {
+          dlimb_t d = static_cast<dlimb_t>(a[p]) - b[p] - carry[l];
+          r[p] = static_cast<limb_t>(d);
+          carry[l] = static_cast<limb_t>(d >> (2 * LIMB_BITS - 1));
+        } else {
+          dlimb_t s = static_cast<dlimb_t>(a[p]) + b[p] + carry[l];
+          r[p] = static_cast<limb_t>(s);
+          carry[l] = static_cast<limb_t>(s >> LIMB_BITS);
+        }
+      }
+    }
+  }
+}
+
+// Число j пакета подряд в x[0, len) и обратно.
+static void batch_gather(limb_t* x, const limb_t* a, size_t stride, size_t len, size_t j) {
+  for (size_t i = 0; i < len; i++) {
+    x[i] = a[i * stride + j];
+  }
+}
+
+static void batch_scatter(limb_t* r, const limb_t* x, size_t stride, size_t len, size_t j) {
+  for (size_t i = 0; i < len; i++) {
+    r[i * stride + j] = x[i];
+  }
+}
+
+static void batch_mul_scalar(limb_t* r, const limb_t* a, const limb_t* b, size_t stride, size_t len) {
+  limb_buffer buf(4 * len + mul_n_itch(len));
+  limb_t* x = buf.data();
+  limb_t* y = x + len;
+  limb_t* t = y + len;
+  for (size_t j = 0; j < stride; j++) {
+    batch_gather(x, a, stride, len, j);
+    batch_gather(y, b, stride, len, j);
+    mul_n(t, x, y, len, t + 2 * len);
+    batch_scatter(r, t, stride, 2 * len, j);
+  }
+}
+
+// r = a * b mod m: a * b * β^{-len} и ещё раз на r2 = β^{2 len} mod m.
+static void batch_modmul_scalar(limb_t* r, const limb_t* a, const limb_t* b, size_t stride, size_t len,
+                                const limb_t* m, limb_t minv, const limb_t* r2) {
+  mont_workspace ws(m, len, minv);
+  limb_buffer buf(2 * len);
+  limb_t* x = buf.data();
+  limb_t* y = x + len;
+  for (size_t j = 0; j < stride; j++) {
+    batch_gather(x, a, stride, len, j);
+    batch_gather(y, b, stride, len, j);
+    ws.mul(x, x, y);
+    ws.mul(x, x, r2);
+    batch_scatter(r, x, stride, len, j);
+  }
+}
+
+#ifdef BIG_INTEGER_X86_SIMD
+
+// Вектор - восемь чисел группы, по одному 64-битному элементу на число. Цифры - 32-битные части
+// лимбов в младших половинах элементов.
+const size_t DIGITS_PER_LIMB = LIMB_BITS / 32;
+
+// Сдвиги, преобразования и vpmuludq берутся в маскированной форме с полной маской: на немаскированные GCC 12
+// ложно предупреждает о неинициализированном операнде.
+const __mmask8 ALL_LANES = 0xff;
+
+// n векторов в буфере из пула с выравниванием на 64 байта.
+static __m512i* batch_vectors(limb_buffer& buf, size_t n) {
+  const size_t per_vector = 64 / sizeof(limb_t);
+  buf.assign((n + 1) * per_vector, 0);
+  auto p = reinterpret_cast<std::uintptr_t>(buf.data());
+  return reinterpret_cast<__m512i*>((p + 63) & ~std::uintptr_t(63));
+}
+
+__attribute__((target("avx512f"))) static __m512i batch_load(const limb_t* p) {
+  if constexpr (LIMB_BITS == 64) {
+    return _mm512_loadu_si512(p);
+  } else {
+    return _mm512_maskz_cvtepu32_epi64(ALL_LANES, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p)));
+  }
+}
+
+__attribute__((target("avx512f"))) static void batch_store(limb_t* p, __m512i v) {
+  if constexpr (LIMB_BITS == 64) {
+    _mm512_storeu_si512(p, v);
+  } else {
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(p), _mm512_maskz_cvtepi64_epi32(ALL_LANES, v));
+  }
+}
+
+template <bool SUB>
+__attribute__((target("avx512f"))) static void batch_add_sub_avx512(limb_t* r, const limb_t* a, const limb_t* b,
+                                                                    size_t stride, size_t len) {
+  const __m512i one = _mm512_set1_epi64(1);
+  for (size_t j = 0; j < stride; j += BATCH_LANES) {
+    __mmask8 carry = 0;
+    __m512i carry32 = _mm512_setzero_si512();
+    for (size_t i = 0; i < len; i++) {
+      size_t p = i * stride + j;
+      __m512i x = batch_load(a + p);
+      __m512i y = batch_load(b + p);
+      if constexpr (LIMB_BITS == 64) {
+        // Перенос возникает при переполнении x +- y или при x +- y == MAX (0) и входящем переносе.
+        __m512i s = SUB ? _mm512_sub_epi64(x, y) : _mm512_add_epi64(x, y);
+        __mmask8 c = SUB ? _mm512_cmplt_epu64_mask(x, y) : _mm512_cmplt_epu64_mask(s, x);
+        if constexpr (SUB) {
+          c |= _mm512_mask_cmpeq_epi64_mask(carry, s, _mm512_setzero_si512());
+          s = _mm512_mask_sub_epi64(s, carry, s, one);
+        } else {
+          c |= _mm512_mask_cmpeq_epi64_mask(carry, s, _mm512_set1_epi64(-1));
+          s = _mm512_mask_add_epi64(s, carry, s, one);
+        }
+        carry = c;
+        batch_store(r + p, s);
+      } else {
+        // 32-битные лимбы считаются в 64-битных элементах, перенос - старшая половина.
+        __m512i s = SUB ? _mm512_sub_epi64(_mm512_sub_epi64(x, y), carry32)
+                        : _mm512_add_epi64(_mm512_add_epi64(x, y), carry32);
+        carry32 = SUB ? _mm512_maskz_srli_epi64(ALL_LANES, s, 63) : _mm512_maskz_srli_epi64(ALL_LANES, s, 32);
+        batch_store(r + p, s);
+      }
+    }
+  }
+}
+
+// Цифры лимбов [0, len) группы j: d[0, len * DIGITS_PER_LIMB).
+__attribute__((target("avx512f"))) static void batch_load_digits(__m512i* d, const limb_t* a, size_t stride,
+                                                                 size_t len, size_t j) {
+  for (size_t i = 0; i < len; i++) {
+    __m512i v = batch_load(a + i * stride + j);
+    if constexpr (LIMB_BITS == 64) {
+      d[2 * i] = v;
+      d[2 * i + 1] = _mm512_maskz_srli_epi64(ALL_LANES, v, 32);
+    } else {
+      d[i] = v;
+    }
+  }
+}
+
+// Обратно: цифры d[0, len * DIGITS_PER_LIMB) меньше 2^32.
+__attribute__((target("avx512f"))) static void batch_store_digits(limb_t* r, const __m512i* d, size_t stride,
+                                                                  size_t len, size_t j) {
+  for (size_t i = 0; i < len; i++) {
+    if constexpr (LIMB_BITS == 64) {
+      batch_store(r + i * stride + j, _mm512_or_si512(d[2 * i], _mm512_maskz_slli_epi64(ALL_LANES, d[2 * i + 1], 32)));
+    } else {
+      batch_store(r + i * stride + j, d[i]);
+    }
+  }
+}
+
+// Цифры одного числа, размноженные на все элементы вектора.
+__attribute__((target("avx512f"))) static void batch_broadcast_digits(__m512i* d, const limb_t* a, size_t len) {
+  for (size_t i = 0; i < len * DIGITS_PER_LIMB; i++) {
+    d[i] = _mm512_set1_epi64(static_cast<std::uint32_t>(a[i / DIGITS_PER_LIMB] >> (i % DIGITS_PER_LIMB * 32)));
+  }
+}
+
+// Столбец (lo, hi) += x * y: младшие и старшие половины произведений копятся отдельно,
+// переполнения нет, пока в столбце меньше 2^31 слагаемых.
+__attribute__((target("avx512f"))) static void batch_mac(__m512i& lo, __m512i& hi, __m512i x, __m512i y) {
+  const __m512i mask = _mm512_set1_epi64(0xffffffff);
+  __m512i p = _mm512_maskz_mul_epu32(ALL_LANES, x, y);
+  lo = _mm512_add_epi64(lo, _mm512_and_si512(p, mask));
+  hi = _mm512_add_epi64(hi, _mm512_maskz_srli_epi64(ALL_LANES, p, 32));
+}
+
+// Выдаёт младшую цифру столбца и переносит остальное в следующий.
+__attribute__((target("avx512f"))) static __m512i batch_column_digit(__m512i& lo, __m512i& hi) {
+  __m512i digit = _mm512_and_si512(lo, _mm512_set1_epi64(0xffffffff));
+  lo = _mm512_add_epi64(_mm512_maskz_srli_epi64(ALL_LANES, lo, 32), hi);
+  hi = _mm512_setzero_si512();
+  return digit;
+}
+
+// Умножение столбцами: r[0, 2n) = x[0, n) * y[0, n) в цифрах.
+__attribute__((target("avx512f"))) static void batch_comba(__m512i* r, const __m512i* x, const __m512i* y,
+                                                           size_t n) {
+  __m512i lo = _mm512_setzero_si512();
+  __m512i hi = _mm512_setzero_si512();
+  for (size_t k = 0; k + 1 < 2 * n; k++) {
+    size_t i1 = std::min(k, n - 1);
+    for (size_t i = k < n ? 0 : k - n + 1; i <= i1; i++) {
+      batch_mac(lo, hi, x[i], y[k - i]);
+    }
+    r[k] = batch_column_digit(lo, hi);
+  }
+  r[2 * n - 1] = lo;
+}
+
+// Монтгомери столбцами (product scanning): r[0, n) = x * y * 2^{-32n} mod m, x, y < m.
+// u[0, n) - буфер под множители редукции, mp - (-m^{-1}) mod 2^32.
+__attribute__((target("avx512f"))) static void batch_mont(__m512i* r, const __m512i* x, const __m512i* y,
+                                                          const __m512i* m, __m512i mp, __m512i* u, size_t n) {
+  const __m512i mask = _mm512_set1_epi64(0xffffffff);
+  __m512i lo = _mm512_setzero_si512();
+  __m512i hi = _mm512_setzero_si512();
+  for (size_t k = 0; k < n; k++) {
+    for (size_t i = 0; i < k; i++) {
+      batch_mac(lo, hi, x[i], y[k - i]);
+      batch_mac(lo, hi, u[i], m[k - i]);
+    }
+    batch_mac(lo, hi, x[k], y[0]);
+    // Младшая цифра столбца обнуляется прибавлением u_k * m.
+    u[k] = _mm512_and_si512(_mm512_maskz_mul_epu32(ALL_LANES, lo, mp), mask);
+    batch_mac(lo, hi, u[k], m[0]);
+    batch_column_digit(lo, hi);
+  }
+  for (size_t k = n; k + 1 < 2 * n; k++) {
+    for (size_t i = k - n + 1; i < n; i++) {
+      batch_mac(lo, hi, x[i], y[k - i]);
+      batch_mac(lo, hi, u[i], m[k - i]);
+    }
+    r[k - n] = batch_column_digit(lo, hi);
+  }
+  r[n - 1] = batch_column_digit(lo, hi);
+
+  // Результат (lo; r) меньше 2m, вычитаем m там, где он не меньше m.
+  __m512i borrow = _mm512_setzero_si512();
+  for (size_t k = 0; k < n; k++) {
+    __m512i d = _mm512_sub_epi64(_mm512_sub_epi64(r[k], m[k]), borrow);
+    borrow = _mm512_maskz_srli_epi64(ALL_LANES, d, 63);
+    u[k] = _mm512_and_si512(d, mask);
+  }
+  __mmask8 ge = _mm512_cmpneq_epi64_mask(lo, _mm512_setzero_si512()) |
+                _mm512_cmpeq_epi64_mask(borrow, _mm512_setzero_si512());
+  for (size_t k = 0; k < n; k++) {
+    r[k] = _mm512_mask_blend_epi64(ge, r[k], u[k]);
+  }
+}
+
+__attribute__((target("avx512f"))) static void batch_mul_avx512(limb_t* r, const limb_t* a, const limb_t* b,
+                                                                size_t stride, size_t len) {
+  // Столбцы квадратичны, а скалярный путь с Карацубой на таких длинах уже не медленнее.
+  if (len >= KARATSUBA_THRESHOLD) {
+    batch_mul_scalar(r, a, b, stride, len);
+    return;
+  }
+  size_t n = len * DIGITS_PER_LIMB;
+  limb_buffer buf;
+  __m512i* x = batch_vectors(buf, 4 * n);
+  __m512i* y = x + n;
+  __m512i* t = y + n;
+  for (size_t j = 0; j < stride; j += BATCH_LANES) {
+    batch_load_digits(x, a, stride, len, j);
+    batch_load_digits(y, b, stride, len, j);
+    batch_comba(t, x, y, n);
+    batch_store_digits(r, t, stride, 2 * len, j);
+  }
+}
+
+__attribute__((target("avx512f"))) static void batch_modmul_avx512(limb_t* r, const limb_t* a, const limb_t* b,
+                                                                   size_t stride, size_t len, const limb_t* m,
+                                                                   limb_t minv, const limb_t* r2) {
+  size_t n = len * DIGITS_PER_LIMB;
+  limb_buffer buf;
+  __m512i* x = batch_vectors(buf, 6 * n);
+  __m512i* y = x + n;
+  __m512i* t = y + n;
+  __m512i* u = t + n;
+  __m512i* md = u + n;
+  __m512i* rd = md + n;
+  batch_broadcast_digits(md, m, len);
+  batch_broadcast_digits(rd, r2, len);
+  __m512i mp = _mm512_set1_epi64(static_cast<std::uint32_t>(minv));
+  for (size_t j = 0; j < stride; j += BATCH_LANES) {
+    batch_load_digits(x, a, stride, len, j);
+    batch_load_digits(y, b, stride, len, j);
+    batch_mont(t, x, y, md, mp, u, n);
+    batch_mont(x, t, rd, md, mp, u, n);
+    batch_store_digits(r, x, stride, len, j);
+  }
+}
+
+#endif
+
+struct batch_kernels {
+  void (*add)(limb_t* r, const limb_t* a, const limb_t* b, size_t stride, size_t len);
+  void (*sub)(limb_t* r, const limb_t* a, const limb_t* b, size_t stride, size_t len);
+  void (*mul)(limb_t* r, const limb_t* a, const limb_t* b, size_t stride, size_t len);
+  void (*modmul)(limb_t* r, const limb_t* a, const limb_t* b, size_t stride, size_t len, const limb_t* m, limb_t minv,
+                 const limb_t* r2);
+};
+
+static batch_kernels select_batch_kernels() {
+  batch_kernels k = {batch_add_sub_scalar<false>, batch_add_sub_scalar<true>, batch_mul_scalar, batch_modmul_scalar};
+#ifdef BIG_INTEGER_X86_SIMD
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx512f")) {
+    k = {batch_add_sub_avx512<false>, batch_add_sub_avx512<true>, batch_mul_avx512, batch_modmul_avx512};
+  }
+#endif
+  return k;
+}
+
+static const batch_kernels& batch_kernels_table() {
+  static const batch_kernels k = select_batch_kernels();
+  return k;
+}
+
+// Операнды из одинакового числа чисел длины n, результат длины rn.
+static void batch_check(const big_integer_batch& r, size_t rn, const big_integer_batch& a, const big_integer_batch& b,
+                        size_t n) {
+  if (a.size() != b.size() || r.size() != a.size() || a.limbs() != n || b.limbs() != n || r.limbs() != rn) {
+    throw std::invalid_argument("Batch shapes do not match");
+  }
+}
+
+void batch_add(big_integer_batch& r, const big_integer_batch& a, const big_integer_batch& b) {
+  batch_check(r, a.limbs(), a, b, a.limbs());
+  batch_kernels_table().add(r.data(), a.data(), b.data(), a.stride(), a.limbs());
+}
+
+void batch_sub(big_integer_batch& r, const big_integer_batch& a, const big_integer_batch& b) {
+  batch_check(r, a.limbs(), a, b, a.limbs());
+  batch_kernels_table().sub(r.data(), a.data(), b.data(), a.stride(), a.limbs());
+}
+
+void batch_mul(big_integer_batch& r, const big_integer_batch& a, const big_integer_batch& b) {
+  batch_check(r, 2 * a.limbs(), a, b, a.limbs());
+  if (a.limbs() > 0) {
+    batch_kernels_table().mul(r.data(), a.data(), b.data(), a.stride(), a.limbs());
+  }
+}
+
+void batch_modmul(big_integer_batch& r, const big_integer_batch& a, const big_integer_batch& b,
+                  const montgomery_context& ctx) {
+  size_t n = ctx.mod.size();
+  batch_check(r, n, a, b, n);
+  limb_buffer r2(n, 0);
+  std::copy(ctx.r2.limbs.begin(), ctx.r2.limbs.end(), r2.begin());
+  batch_kernels_table().modmul(r.data(), a.data(), b.data(), a.stride(), n, ctx.mod.limbs.data(), ctx.minv, r2.data());
+}
+
+// НОД. Матрица m[0..3] = (m00, m01, m10, m11) связывает текущие (a; b) = M (a0; b0) с исходными числами:
+// по ней получаются коэффициенты Безу и переносятся на полные числа шаги, найденные по старшим частям.
+// Все шаги унимодулярны, поэтому НОД и коэффициенты верны, даже если шаг по усечённым числам разошёлся
+// с алгоритмом Евклида; от точности шагов зависит только скорость.
+
+// Без матрицы шаги Лемера дешевле, поэтому простой НОД переходит на половинный позже.
+const size_t HGCD_THRESHOLD = 100;
+const size_t GCD_HGCD_THRESHOLD = 250;
+
+static void matrix_rows(big_integer* m, big_integer r0, big_integer r1, big_integer r2, big_integer r3) {
+  m[0] = std::move(r0);
+  m[1] = std::move(r1);
+  m[2] = std::move(r2);
+  m[3] = std::move(r3);
+}
+
+// Один шаг деления: (a, b) = (b, a mod b).
+void big_integer::euclid_step(big_integer& a, big_integer& b, big_integer* m) {
+  big_integer q = a;
+  big_integer r = div(q, b, true);
+  std::swap(a, b);
+  b = std::move(r);
+  if (m != nullptr) {
+    m[0] -= q * m[2];
+    m[1] -= q * m[3];
+    std::swap(m[0], m[2]);
+    std::swap(m[1], m[3]);
+  }
+}
+
+// Шаг Лемера (a >= b, в a больше LIMB_BITS бит): частные считаются по старшему слову a и битам b на той же
+// позиции, пока выполняется условие Жебеляну (с запасом для обеих чётностей, так что частные совпадают
+// с частными полных чисел), затем a и b пересчитываются одной линейной комбинацией.
+// Если не гарантировано ни одно частное, делается обычный шаг деления.
+void big_integer::lehmer_step(big_integer& a, big_integer& b, big_integer* m) {
+  size_t sh = a.bit_length() - LIMB_BITS;
+  auto top = [w = sh / LIMB_BITS, s = sh % LIMB_BITS](const big_integer& v) {
+    limb_t t = v.get(w) >> s;
+    if (s != 0) {
+      t |= v.get(w + 1) << (LIMB_BITS - s);
+    }
+    return t;
+  };
+  limb_t x = top(a);
+  limb_t y = top(b);
+
+  // Остатки r_i = (-1)^i (u_i a - v_i b); (x, y) = (r_k, r_{k+1}), u0, v0 и u1, v1 - их коэффициенты.
+  limb_t u0 = 1;
+  limb_t v0 = 0;
+  limb_t u1 = 0;
+  limb_t v1 = 1;
+  size_t k = 0;
+  while (y != 0) {
+    limb_t q = x / y;
+    limb_t r = x - q * y;
+    dlimb_t u2 = u0 + static_cast<dlimb_t>(q) * u1;
+    dlimb_t v2 = v0 + static_cast<dlimb_t>(q) * v1;
+    if (r < std::max(u2, v2) || y - r < std::max(u1 + u2, v1 + v2)) {
+      break;
+    }
+    u0 = u1;
+    v0 = v1;
+    u1 = static_cast<limb_t>(u2);
+    v1 = static_cast<limb_t>(v2);
+    x = y;
+    y = r;
+    k++;
+  }
+  if (k == 0) {
+    euclid_step(a, b, m);
+    return;
+  }
+
+  size_t n = a.size();
+  limb_buffer bl(n, 0);
+  std::copy(std::as_const(b.limbs).begin(), std::as_const(b.limbs).end(), bl.begin());
+  const limb_t* al = std::as_const(a.limbs).data();
+  // res = x * X - y * Y, по условию Жебеляну неотрицательно.
+  auto comb = [n](const limb_t* x, limb_t X, const limb_t* y, limb_t Y) {
+    big_integer res;
+    res.limbs.resize(n + 1);
+    limb_t* r = res.limbs.data();
+    limb_t hi = mul_1(r, x, n, X);
+    r[n] = hi - submul_1(r, y, n, Y);
+    res.normalization();
+    return res;
+  };
+  auto comb_row = [](const big_integer& x, limb_t X, const big_integer& y, limb_t Y) {
+    big_integer res = x * big_integer(X);
+    res -= y * big_integer(Y);
+    return res;
+  };
+  if (k % 2 == 0) {
+    big_integer na = comb(al, u0, bl.data(), v0);
+    b = comb(bl.data(), v1, al, u1);
+    a = std::move(na);
+    if (m != nullptr) {
+      matrix_rows(m, comb_row(m[0], u0, m[2], v0), comb_row(m[1], u0, m[3], v0), comb_row(m[2], v1, m[0], u1),
+                  comb_row(m[3], v1, m[1], u1));
+    }
+  } else {
+    big_integer na = comb(bl.data(), v0, al, u0);
+    b = comb(al, u1, bl.data(), v1);
+    a = std::move(na);
+    if (m != nullptr) {
+      matrix_rows(m, comb_row(m[2], v0, m[0], u0), comb_row(m[3], v0, m[1], u0), comb_row(m[0], u1, m[2], v1),
+                  comb_row(m[1], u1, m[3], v1));
+    }
+  }
+}
+
+// (a; b) = mm (a; b), затем m = mm m. Знаки и порядок a >= b >= 0 восстанавливаются сменой знака
+// и перестановкой строк mm: после шагов по старшим частям они почти всегда и так верны.
+static void hgcd_apply(big_integer& a, big_integer& b, big_integer* mm, big_integer* m) {
+  big_integer na = mm[0] * a;
+  na += mm[1] * b;
+  big_integer nb = mm[2] * a;
+  nb += mm[3] * b;
+  if (na < 0) {
+    na.get_negate(true);
+    mm[0].get_negate(true);
+    mm[1].get_negate(true);
+  }
+  if (nb < 0) {
+    nb.get_negate(true);
+    mm[2].get_negate(true);
+    mm[3].get_negate(true);
+  }
+  if (na < nb) {
+    std::swap(na, nb);
+    std::swap(mm[0], mm[2]);
+    std::swap(mm[1], mm[3]);
+  }
+  a = std::move(na);
+  b = std::move(nb);
+  if (m != nullptr) {
+    big_integer r0 = mm[0] * m[0];
+    r0 += mm[1] * m[2];
+    big_integer r1 = mm[0] * m[1];
+    r1 += mm[1] * m[3];
+    big_integer r2 = mm[2] * m[0];
+    r2 += mm[3] * m[2];
+    big_integer r3 = mm[2] * m[1];
+    r3 += mm[3] * m[3];
+    matrix_rows(m, std::move(r0), std::move(r1), std::move(r2), std::move(r3));
+  }
+}
+
+// Шаги, найденные половинным НОД по битам a и b начиная с p, применяются к полным числам. Старшие части
+// уменьшаются вдвое с запасом в лимб: коэффициенты матрицы меньше 2^{-LIMB_BITS} от остатков,
+// и младшие биты меняют результат меньше, чем на его долю 2^{-LIMB_BITS}.
+void big_integer::hgcd_part(big_integer& a, big_integer& b, size_t p, big_integer* m) {
+  big_integer ah = a >> static_cast<int>(p);
+  big_integer bh = b >> static_cast<int>(p);
+  size_t s = ah.bit_length() / 2 + LIMB_BITS;
+  if (bh.bit_length() <= s + 2 * LIMB_BITS) {
+    return;
+  }
+  big_integer mm[4] = {1, 0, 0, 1};
+  hgcd(ah, bh, s, mm);
+  hgcd_apply(a, b, mm, m);
+}
+
+// Половинный НОД: уменьшает a >= b, пока b длиннее s + 2 * LIMB_BITS бит, не опуская b заметно ниже 2^s.
+// Для длинных чисел - два рекурсивных вызова на половинной длине: по старшим n - s битам, затем по старшей
+// части уже уменьшенных чисел, что даёт O(M(n) log n). Остаток пути и короткие числа - шаги Лемера.
+void big_integer::hgcd(big_integer& a, big_integer& b, size_t s, big_integer* m) {
+  if (a.size() >= HGCD_THRESHOLD) {
+    hgcd_part(a, b, s, m);
+    size_t n = a.bit_length();
+    if (2 * s > n + 2 * LIMB_BITS) {
+      hgcd_part(a, b, 2 * s - n - 2 * LIMB_BITS, m);
+    }
+  }
+  while (b.bit_length() > s + 2 * LIMB_BITS) {
+    lehmer_step(a, b, m);
+  }
+}
+
+// Сводит a >= b >= 0 к (НОД, 0).
+void big_integer::gcd_reduce(big_integer& a, big_integer& b, big_integer* m) {
+  while (b.size() > 1) {
+    if (a.size() > b.size() + 1) {
+      euclid_step(a, b, m);
+    } else if (b.size() >= (m == nullptr ? GCD_HGCD_THRESHOLD : HGCD_THRESHOLD)) {
+      hgcd(a, b, a.bit_length() / 2, m);
+    } else {
+      lehmer_step(a, b, m);
+    }
+  }
+  if (m == nullptr && b.size() == 1) {
+    limb_t r = div_small(a, b.limbs[0]);
+    a = std::gcd(b.limbs[0], r);
+    b = 0;
+  }
+  while (b != 0) {
+    euclid_step(a, b, m);
+  }
+}
+
+big_integer gcd(const big_integer& a, const big_integer& b) {
+  big_integer x = a;
+  big_integer y = b;
+  x.get_absolute(true);
+  y.get_absolute(true);
+  if (x < y) {
+    std::swap(x, y);
+  }
+  big_integer::gcd_reduce(x, y, nullptr);
+  return x;
+}
+
+big_integer xgcd(const big_integer& a, const big_integer& b, big_integer& s, big_integer& t) {
+  bool a_neg = a < 0;
+  bool b_neg = b < 0;
+  big_integer x = a;
+  big_integer y = b;
+  x.get_absolute(true);
+  y.get_absolute(true);
+  big_integer m[4] = {1, 0, 0, 1};
+  if (x < y) {
+    std::swap(x, y);
+    std::swap(m[0], m[1]);
+    std::swap(m[2], m[3]);
+  }
+  big_integer::gcd_reduce(x, y, m);
+  s = std::move(m[0]);
+  t = std::move(m[1]);
+  if (a_neg) {
+    s.get_negate(true);
+  }
+  if (b_neg) {
+    t.get_negate(true);
+  }
+  return x;
+}
+
+big_integer invert(const big_integer& a, const big_integer& m) {
+  big_integer mod = m;
+  mod.get_absolute(true);
+  if (mod == 0) {
+    throw std::invalid_argument("Division by zero");
+  }
+  big_integer r = a % mod;
+  if (r < 0) {
+    r += mod;
+  }
+  big_integer s;
+  big_integer t;
+  if (xgcd(r, mod, s, t) != 1) {
+    throw std::invalid_argument("Not invertible");
+  }
+  s %= mod;
+  if (s < 0) {
+    s += mod;
+  }
+  return s;
+}
+
+// Целые корни.
+
+// x^e двоичным возведением.
+static big_integer ipow(const big_integer& x, size_t e) {
+  big_integer res = 1;
+  big_integer b = x;
+  while (e > 0) {
+    if (e & 1) {
+      res *= b;
+    }
+    e >>= 1;
+    if (e > 0) {
+      b = square(std::move(b));
+    }
+  }
+  return res;
+}
+
+// Оценка сверху для floor(n^{1/k}) по старшим 53 битам n: log2 n = e + log2 m, 1 <= m < 2, и корень равен
+// 2^{floor(e / k)} * 2^f, f = (e mod k + log2 m) / k < 1. В double 2^f верен примерно до 2^{-50},
+// запас 2^{-44} и единица после сдвига делают оценку не меньше корня.
+static big_integer root_estimate(const big_integer& n, size_t k) {
+  size_t e = n.bit_length() - 1;
+  double m = 0;
+  for (size_t i = 0; i < 53 && i <= e; i++) {
+    if (n.test_bit(e - i)) {
+      m += std::ldexp(1.0, -static_cast<int>(i));
+    }
+  }
+  double f = (static_cast<double>(e % k) + std::log2(m)) / static_cast<double>(k);
+  auto y = static_cast<unsigned long long>(std::ldexp(std::exp2(f), 52));
+  y += (y >> 44) + 2;
+  return ((big_integer(y) << static_cast<int>(e / k)) >> 52) + 1;
+}
+
+// floor(n^{1/k}) для n > 0, k >= 2. Корень из старших битов n (без младших k * j) сдвигается на j и даёт
+// приближение снизу с относительной ошибкой около 2^{j - r}; один шаг Ньютона x = ((k - 1) x + n / x^{k-1}) / k
+// возводит её в квадрат и даёт значение не меньше ответа, а выбор j оставляет лишь единицу-другую сверху.
+// Короткий корень (r < 4 * (bit_width(k) + 2), тогда j < r / 4 и рекурсия почти не укорачивает задачу) считается
+// шагами Ньютона от оценки сверху по double: они убывают, пока не дойдут до ответа, и их всего несколько.
+static big_integer root_newton(const big_integer& n, size_t k) {
+  size_t r = (n.bit_length() + k - 1) / k;
+  if (r == 1) {
+    // n < 2^k; оценка 2 дала бы 2^{k - 1} бит на возведение.
+    return 1;
+  }
+  size_t guard = std::bit_width(k) + 2;
+  if (r <= 32 || r < 4 * guard) {
+    big_integer x = root_estimate(n, k);
+    while (true) {
+      big_integer y = (x * big_integer(k - 1) + n / ipow(x, k - 1)) / big_integer(k);
+      if (y >= x) {
+        return x;
+      }
+      x = std::move(y);
+    }
+  }
+  size_t j = r / 2 - guard;
+  big_integer x = root_newton(n >> static_cast<int>(k * j), k) << static_cast<int>(j);
+  x = (x * big_integer(k - 1) + n / ipow(x, k - 1)) / big_integer(k);
+  while (ipow(x, k) > n) {
+    --x;
+  }
+  return x;
+}
+
+big_integer iroot(const big_integer& n, unsigned k) {
+  if (k == 0) {
+    throw std::invalid_argument("Zero root degree");
+  }
+  if (n < 0) {
+    if (k % 2 == 0) {
+      throw std::invalid_argument("Even root of negative number");
+    }
+    return -iroot(-n, k);
+  }
+  if (k == 1 || n == 0) {
+    return n;
+  }
+  return root_newton(n, k);
+}
+
+big_integer isqrt(const big_integer& n) {
+  return iroot(n, 2);
+}
+
+// Произведения многих множителей.
+
+// Отрезок [lo, hi) делится там, где префиксная сумма длин bits набирает половину.
+static big_integer product_tree(const big_integer* a, const size_t* bits, size_t lo, size_t hi) {
+  if (hi - lo == 1) {
+    return a[lo];
+  }
+  size_t mid = std::lower_bound(bits + lo + 1, bits + hi, (bits[lo] + bits[hi]) / 2) - bits;
+  mid = std::clamp(mid, lo + 1, hi - 1);
+  return product_tree(a, bits, lo, mid) * product_tree(a, bits, mid, hi);
+}
+
+big_integer product(contiguous_view<const big_integer> factors) {
+  size_t n = factors.size();
+  if (n == 0) {
+    return 1;
+  }
+  std::vector<size_t> bits(n + 1, 0);
+  for (size_t i = 0; i < n; i++) {
+    bits[i + 1] = bits[i] + factors[i].bit_length();
+  }
+  return product_tree(factors.data(), bits.data(), 0, n);
+}
+
+const size_t PRODUCT_LEAF = 16;
+
+// Произведение чисел a[0, n), каждое меньше β. В листьях множители домножаются по одному,
+// выше - дерево из умножений половин.
+static limb_buffer product_limbs(const limb_t* a, size_t n) {
+  limb_buffer r;
+  if (n <= PRODUCT_LEAF) {
+    r.assign(n + 1, 0);
+    r[0] = 1;
+    size_t len = 1;
+    for (size_t i = 0; i < n; i++) {
+      limb_t carry = mul_1(r.data(), r.data(), len, a[i]);
+      if (carry != 0) {
+        r[len++] = carry;
+      }
+    }
+    r.resize(len);
+    return r;
+  }
+  limb_buffer x = product_limbs(a, n / 2);
+  limb_buffer y = product_limbs(a + n / 2, n - n / 2);
+  r.resize(x.size() + y.size());
+  mul_mag(r.data(), x.data(), x.size(), y.data(), y.size());
+  while (r.size() > 1 && r.back() == 0) {
+    r.pop_back();
+  }
+  return r;
+}
+
+// Соседние множители сначала собираются в лимбы, пока произведение в них помещается.
+static big_integer::limbs_t product_small(std::vector<limb_t>& f) {
+  size_t n = 0;
+  for (limb_t x : f) {
+    if (n > 0 && (static_cast<dlimb_t>(f[n - 1]) * x >> LIMB_BITS) == 0) {
+      f[n - 1] *= x;
+    } else {
+      f[n++] = x;
+    }
+  }
+  limb_buffer p = product_limbs(f.data(), n);
+  big_integer::limbs_t res;
+  res.resize(p.size());
+  std::copy(p.begin(), p.end(), res.data());
+  return res;
+}
+
+// Нечётные простые до n включительно (решето по нечётным).
+static std::vector<unsigned> odd_primes(unsigned n) {
+  std::vector<unsigned> res;
+  if (n < 3) {
+    return res;
+  }
+  std::vector<bool> composite(n / 2 + 1);
+  for (size_t i = 3; i <= n; i += 2) {
+    if (!composite[i / 2]) {
+      res.push_back(static_cast<unsigned>(i));
+      for (size_t j = i * i; j <= n; j += 2 * i) {
+        composite[j / 2] = true;
+      }
+    }
+  }
+  return res;
+}
+
+// Нечётная часть swing(n) = n! / ((n/2)!)^2: показатель простого p - число нечётных floor(n / p^i).
+static big_integer::limbs_t odd_swing(unsigned n, const std::vector<unsigned>& primes) {
+  std::vector<limb_t> factors;
+  for (unsigned p : primes) {
+    if (p > n) {
+      break;
+    }
+    limb_t pe = 1;
+    for (unsigned q = n / p; q > 0; q /= p) {
+      if (q & 1) {
+        pe *= p;
+      }
+    }
+    if (pe > 1) {
+      factors.push_back(pe);
+    }
+  }
+  return product_small(factors);
+}
+
+// odd(n!) = odd((n/2)!)^2 * odd(swing(n)), степень двойки n! равна n - popcount(n).
+big_integer factorial(unsigned n) {
+  std::vector<unsigned> primes = odd_primes(n);
+  std::vector<unsigned> levels;
+  for (unsigned m = n; m >= 3; m /= 2) {
+    levels.push_back(m);
+  }
+  big_integer res = 1;
+  for (size_t i = levels.size(); i-- > 0;) {
+    big_integer swing;
+    swing.limbs = odd_swing(levels[i], primes);
+    swing.normalization();
+    res = square(std::move(res)) * swing;
+  }
+  res <<= static_cast<int>(n - std::popcount(n));
+  return res;
+}
+
+big_integer binomial(unsigned n, unsigned k) {
+  if (k > n) {
+    return 0;
+  }
+  k = std::min(k, n - k);
+  std::vector<limb_t> factors;
+  big_integer res;
+  if (static_cast<std::uint64_t>(k) * 16 < n) {
+    // Решето до n дороже короткого произведения n (n - 1) ... (n - k + 1), которое делится на k! нацело.
+    for (unsigned i = 0; i < k; i++) {
+      factors.push_back(n - i);
+    }
+    res.limbs = product_small(factors);
+    res.normalization();
+    return res / factorial(k);
+  }
+  // Показатель p - число заёмов при вычитании k из n в системе счисления p (теорема Куммера).
+  unsigned twos = std::popcount(k) + std::popcount(n - k) - std::popcount(n);
+  for (unsigned p : odd_primes(n)) {
+    limb_t pe = 1;
+    for (unsigned a = n / p, b = k / p, c = (n - k) / p; a > 0; a /= p, b /= p, c /= p) {
+      for (unsigned e = a - b - c; e > 0; e--) {
+        pe *= p;
+      }
+    }
+    if (pe > 1) {
+      factors.push_back(pe);
+    }
+  }
+  res.limbs = product_small(factors);
+  res.normalization();
+  res <<= static_cast<int>(twos);
+  return res;
+}
+
+// Битовые операции определены над бесконечным дополнительным кодом: a переводится в него на месте,
+// результат возвращается в знак и модуль. Дополнительный код отрицательного b - нули до первого ненулевого
+// лимба k, -b[k] в нём и ~b выше, поэтому лимбы b не копируются, а инверсия идёт внутри ядра.
+void big_integer::binary_thing(big_integer& a, const big_integer& b, Booleanic op) {
+  if (&a == &b) {
+    big_integer copy(b);
+    binary_thing(a, copy, op);
+    return;
+  }
+  const limb_kernels& kern = kernels();
+  auto op_n = op == Booleanic::AND ? kern.and_n : op == Booleanic::OR ? kern.or_n : kern.xor_n;
+  std::size_t bn = b.limbs.size();
+  std::size_t n = std::max(a.limbs.size(), bn) + 1;
+  a.limbs.resize(n);
+  limb_t* al = a.limbs.data();
+  const limb_t* bl = b.limbs.data();
+  if (a.negate) {
+    negate_n(al, n);
+  }
+
+  std::size_t k = 0;
+  limb_t fill = 0;
+  if (b.negate) {
+    while (bl[k] == 0) {
+      k++;
+    }
+    if (op == Booleanic::AND) {
+      std::fill(al, al + k, 0);
+    }
+    limb_t low = -bl[k];
+    op_n(al + k, &low, 1, 0);
+    k++;
+    fill = MAX;
+  }
+  op_n(al + k, bl + k, bn - k, fill);
+
+  // Старшие лимбы: b продолжается значением fill.
+  if (op == Booleanic::AND && fill == 0) {
+    std::fill(al + bn, al + n, 0);
+  } else if (op == Booleanic::OR && fill == MAX) {
+    std::fill(al + bn, al + n, MAX);
+  } else if (op == Booleanic::XOR && fill == MAX) {
+    kern.not_n(al + bn, n - bn);
+  }
+
+  a.negate = al[n - 1] >> (LIMB_BITS - 1);
+  if (a.negate) {
+    negate_n(al, n);
+  }
+}
+
+big_integer& big_integer::operator&=(const big_integer& rhs) {
+  binary_thing((*this), rhs, Booleanic::AND);
+  (*this).normalization();
+  return *this;
+}
+
+big_integer& big_integer::operator|=(const big_integer& rhs) {
+  binary_thing((*this), rhs, Booleanic::OR);
+  (*this).normalization();
+  return *this;
+}
+
+big_integer& big_integer::operator^=(const big_integer& rhs) {
+  binary_thing((*this), rhs, Booleanic::XOR);
+  (*this).normalization();
+  return *this;
+}
+
+// Сдвиги за один проход по лимбам, память перевыделяется не больше одного раза.
+big_integer& big_integer::operator<<=(int rhs) {
+  size_t n = size();
+  if (n == 0) {
+    return *this;
+  }
+  size_t k = rhs / LIMB_BITS;
+  unsigned s = rhs % LIMB_BITS;
+  limbs.resize(n + k + (s != 0));
+  limb_t* p = limbs.data();
+  if (s == 0) {
+    std::copy_backward(p, p + n, p + n + k);
+  } else {
+    p[n + k] = lshift(p + k, p, n, s);
+  }
+  std::fill(p, p + k, 0);
+  normalization();
+  return *this;
+}
+
+// Сдвиг вправо округляет вниз: для отрицательного a модуль увеличивается на 1,
+// если среди выдвинутых битов модуля есть единицы.
+big_integer& big_integer::operator>>=(int rhs) {
+  size_t n = size();
+  size_t k = rhs / LIMB_BITS;
+  unsigned s = rhs % LIMB_BITS;
+  if (k >= n) {
+    limbs = limbs_t();
+    if (negate) {
+      limbs.push_back(1);
+    }
+    return *this;
+  }
+  limb_t* p = limbs.data();
+  bool round_up = negate && (std::any_of(p, p + k, [](limb_t x) { return x != 0; }) ||
+                             (s != 0 && (p[k] << (LIMB_BITS - s)) != 0));
+  if (s == 0) {
+    std::copy(p + k, p + n, p);
+  } else {
+    rshift(p, p + k, n - k, s);
+  }
+  limbs.resize(n - k);
+  normalization();
+  if (round_up) {
+    add_sub_small(*this, 1, true);
+  }
+  return *this;
+}
+
+// Биты модуля.
+
+size_t big_integer::bit_length() const {
+  return limbs.empty() ? 0 : size() * LIMB_BITS - std::countl_zero(limbs.back());
+}
+
+size_t big_integer::popcount() const {
+  size_t res = 0;
+  for (limb_t x : limbs) {
+    res += std::popcount(x);
+  }
+  return res;
+}
+
+// У a и -a младшая единица на одном месте.
+size_t big_integer::count_trailing_zeros() const {
+  for (size_t i = 0; i < size(); i++) {
+    if (limbs[i] != 0) {
+      return i * LIMB_BITS + std::countr_zero(limbs[i]);
+    }
+  }
+  return 0;
+}
+
+// В дополнительном коде -m биты до младшей единицы m включительно совпадают с битами m, выше - инвертированы.
+bool big_integer::test_bit(size_t i) const {
+  bool bit = (get(i / LIMB_BITS) >> (i % LIMB_BITS)) & 1;
+  return negate && i > count_trailing_zeros() ? !bit : bit;
+}
+
+// Смена бита - это прибавление или вычитание 2^i: модуль растёт, если направление совпадает со знаком.
+void big_integer::set_bit(size_t i, bool value) {
+  if (test_bit(i) == value) {
+    return;
+  }
+  size_t w = i / LIMB_BITS;
+  limb_t bit = limb_t(1) << (i % LIMB_BITS);
+  if (value != negate) {
+    if (size() <= w) {
+      limbs.resize(w + 1);
+    }
+    if (add_1(limbs.data() + w, size() - w, bit) != 0) {
+      limbs.push_back(1);
+    }
+  } else {
+    sub_1(limbs.data() + w, size() - w, bit);
+    normalization();
+  }
+}
+
+// (a >> lo) & (2^n - 1) без промежуточного сдвига всего числа.
+big_integer big_integer::extract_bits(size_t lo, size_t n) const {
+  big_integer res;
+  if (n == 0) {
+    return res;
+  }
+  size_t rn = (n + LIMB_BITS - 1) / LIMB_BITS;
+  size_t w = lo / LIMB_BITS;
+  unsigned s = lo % LIMB_BITS;
+  res.limbs.resize(rn);
+  limb_t* r = res.limbs.data();
+  for (size_t j = 0; j < rn; j++) {
+    r[j] = get(w + j) >> s;
+    if (s != 0) {
+      r[j] |= get(w + j + 1) << (LIMB_BITS - s);
+    }
+  }
+  if (negate) {
+    size_t t = count_trailing_zeros();
+    size_t from = t + 1 > lo ? t + 1 - lo : 0;
+    if (from < rn * LIMB_BITS) {
+      r[from / LIMB_BITS] ^= MAX << (from % LIMB_BITS);
+      kernels().not_n(r + from / LIMB_BITS + 1, rn - from / LIMB_BITS - 1);
+    }
+  }
+  if (n % LIMB_BITS != 0) {
+    r[rn - 1] &= MAX >> (LIMB_BITS - n % LIMB_BITS);
+  }
+  res.normalization();
+  return res;
+}
+
+big_integer big_integer::operator+() const {
+  return *this;
+}
+
+big_integer big_integer::operator-() const {
+  big_integer res(*this);
+  res.get_negate(true);
+  return res;
+}
+
+// ~a = -(a + 1).
+big_integer big_integer::operator~() const {
+  big_integer res(*this);
+  add_sub_small(res, 1, false);
+  res.get_negate(true);
+  return res;
+}
+
+big_integer& big_integer::operator=(const big_integer& other) {
+  big_integer copy = other;
+  limbs.swap(copy.limbs);
+  std::swap((*this).negate, copy.negate);
+  return *this;
+}
+
+big_integer& big_integer::operator=(big_integer&& other) noexcept = default;
+
+big_integer& big_integer::operator++() {
+  add_sub_small(*this, 1, false);
+  return *this;
+}
+
+big_integer big_integer::operator++(int) {
+  big_integer tmp(*this);
+  add_sub_small(*this, 1, false);
+  return tmp;
+}
+
+big_integer& big_integer::operator--() {
+  add_sub_small(*this, 1, true);
+  return *this;
+}
+
+big_integer big_integer::operator--(int) {
+  big_integer tmp(*this);
+  add_sub_small(*this, 1, true);
+  return tmp;
+}
+
+big_integer operator/(big_integer a, const big_integer& b) {
+  a /= b;
+  return a;
+}
+
+big_integer operator%(big_integer a, const big_integer& b) {
+  a %= b;
+  return a;
+}
+
+big_integer operator&(big_integer a, const big_integer& b) {
+  a &= b;
+  return a;
+}
+
+big_integer operator|(big_integer a, const big_integer& b) {
+  a |= b;
+  return a;
 }
 
 big_integer operator^(big_integer a, const big_integer& b) {
-  return a ^= b;
+  a ^= b;
+  return a;
+}
+
+big_integer operator&(const big_integer& a, big_integer&& b) {
+  b &= a;
+  return std::move(b);
+}
+
+big_integer operator|(const big_integer& a, big_integer&& b) {
+  b |= a;
+  return std::move(b);
+}
+
+big_integer operator^(const big_integer& a, big_integer&& b) {
+  b ^= a;
+  return std::move(b);
 }
 
 big_integer operator<<(big_integer a, int b) {
-  return a <<= b;
+  a <<= b;
+  return a;
+}
+
+// Выражения.
+
+void big_integer_eval::add(big_integer& acc, big_integer&& a, bool sub) {
+  if (acc.limbs.empty()) {
+    acc = std::move(a);
+    if (sub) {
+      acc.get_negate(true);
+    }
+  } else {
+    big_integer::add_sub(acc, a, sub);
+  }
+}
+
+void big_integer_eval::add_product(big_integer& acc, const big_integer& a, const big_integer& b, bool sub) {
+  big_integer::add_product(acc, a, b, sub);
+}
+
+// Операнды с общим буфером и одним знаком (a * a, в том числе через копии) - квадрат.
+void big_integer_eval::multiply(big_integer& a, const big_integer& b) {
+  if (a.negate == b.negate && a.size() == b.size() && std::as_const(a.limbs).data() == b.limbs.data()) {
+    big_integer::sqr(a);
+  } else {
+    a.mul(a, b);
+  }
+}
+
+// Неотрицательное a сдвигается сразу в новый буфер, без копирования всего числа.
+big_integer big_integer_eval::shift(const big_integer& a, int bits) {
+  big_integer res;
+  if (a.negate || bits < 0) {
+    res = a;
+    res >>= bits;
+    return res;
+  }
+  size_t n = a.size();
+  size_t k = static_cast<size_t>(bits) / LIMB_BITS;
+  unsigned s = static_cast<unsigned>(bits) % LIMB_BITS;
+  if (k >= n) {
+    return res;
+  }
+  res.limbs.resize(n - k);
+  const limb_t* al = std::as_const(a.limbs).data();
+  if (s == 0) {
+    std::copy(al + k, al + n, res.limbs.data());
+  } else {
+    rshift(res.limbs.data(), al + k, n - k, s);
+  }
+  res.normalization();
+  return res;
+}
+
+big_integer big_integer_eval::shift_and(const big_integer& a, int bits, big_integer mask) {
+  if (mask.negate || a.negate || bits < 0) {
+    mask &= shift(a, bits);
+    return mask;
+  }
+  size_t q = static_cast<size_t>(bits) / LIMB_BITS;
+  unsigned r = static_cast<unsigned>(bits) % LIMB_BITS;
+  for (size_t i = 0; i < mask.size(); i++) {
+    limb_t x = a.get(q + i) >> r;
+    if (r != 0) {
+      x |= a.get(q + i + 1) << (LIMB_BITS - r);
+    }
+    mask.limbs[i] &= x;
+  }
+  mask.normalization();
+  return mask;
+}
+
+// Остаток имеет знак делимого и не зависит от знака m. Если |a ± b| < 2|m|
+// (например, a и b уже приведены), хватает одного сравнения и одного сложения.
+big_integer big_integer_eval::reduce(big_integer res, const big_integer& m) {
+  big_integer m_abs;
+  const big_integer* mp = &m;
+  if (m < 0) {
+    m_abs = -m;
+    mp = &m_abs;
+  }
+  if (res >= 0) {
+    if (res < *mp) {
+      return res;
+    }
+    res -= *mp;
+    if (res >= *mp) {
+      res %= *mp;
+    }
+  } else {
+    res += *mp;
+    if (res > 0) {
+      res -= *mp;
+    } else if (res != 0) {
+      res %= *mp;
+    }
+  }
+  return res;
+}
+
+void addmul(big_integer& acc, const big_integer& a, const big_integer& b) {
+  big_integer::add_product(acc, a, b, false);
+}
+
+void submul(big_integer& acc, const big_integer& a, const big_integer& b) {
+  big_integer::add_product(acc, a, b, true);
 }
 
-big_integer operator>>(big_integer a, int b) {
-  return a >>= b;
+void addmul_limb(big_integer& acc, const big_integer& a, limb_t v) {
+  if (&acc == &a) {
+    big_integer a_copy(a);
+    big_integer::add_product_basecase(acc, a_copy, &v, 1, false, false);
+  } else {
+    big_integer::add_product_basecase(acc, a, &v, 1, false, false);
+  }
 }
 
 bool operator==(const big_integer& a, const big_integer& b) {
-  return a.negate == b.negate && a.limbs == b.limbs;
+  return a.negate == b.negate && a.size() == b.size() && kernels().cmp_n(a.limbs.data(), b.limbs.data(), a.size()) == 0;
 }
 
 bool operator!=(const big_integer& a, const big_integer& b) {
@@ -579,11 +3761,8 @@ bool operator<(const big_integer& a, const big_integer& b) {
   if (a.negate != b.negate) {
     return a.negate;
   }
-  if (a.limbs.size() != b.limbs.size()) {
-    return a.negate ^ (a.limbs.size() < b.limbs.size());
-  } else {
-    return std::lexicographical_compare(a.limbs.rbegin(), a.limbs.rend(), b.limbs.rbegin(), b.limbs.rend());
-  }
+  int cmp = cmp_mag(a.limbs.data(), a.size(), b.limbs.data(), b.size());
+  return a.negate ? cmp > 0 : cmp < 0;
 }
 
 bool operator>(const big_integer& a, const big_integer& b) {
@@ -598,31 +3777,394 @@ bool operator>=(const big_integer& a, const big_integer& b) {
   return !(a < b);
 }
 
+// Перевод в десятичную систему.
+
+const limb_t DECIMAL_CHUNK = LIMB_BITS == 64 ? 10000000000000000000ULL : 1000000000;
+const size_t DECIMAL_CHUNK_DIGITS = LIMB_BITS == 64 ? 19 : 9;
+const size_t TO_STRING_THRESHOLD = 40;
+const size_t DECIMAL_CACHED_POWERS = 16;
+
+// Степени 10^{c * 2^k}, c = DECIMAL_CHUNK_DIGITS, с предвычисленными обратными, общие для всех вызовов в потоке.
+// Между вызовами хранятся только первые DECIMAL_CACHED_POWERS (до 10^{c * 2^15}, около 2 МиБ вместе с mu),
+// старшие степени живут до конца перевода одного числа.
+static std::deque<big_integer_reducer>& decimal_powers() {
+  thread_local std::deque<big_integer_reducer> cache;
+  return cache;
+}
+
+static const big_integer_reducer& decimal_power(size_t k) {
+  std::deque<big_integer_reducer>& cache = decimal_powers();
+  while (cache.size() <= k) {
+    if (cache.empty()) {
+      cache.emplace_back(DECIMAL_CHUNK);
+    } else {
+      const big_integer& p = cache.back().divisor();
+      cache.emplace_back(p * p);
+    }
+  }
+  return cache[k];
+}
+
+// Записывает неотрицательное a < 10^{c * 2^k} ровно в c * 2^k цифр с ведущими нулями.
+// Большие числа делятся пополам по 10^{c * 2^{k-1}}, маленькие - короткими делениями на 10^c.
+void big_integer::write_decimal(big_integer& a, char* out, size_t k) {
+  size_t len = DECIMAL_CHUNK_DIGITS << k;
+  if (k == 0 || a.size() < TO_STRING_THRESHOLD) {
+    char* pos = out + len;
+    while (a.size() > 0) {
+      limb_t chunk = div_small(a, DECIMAL_CHUNK);
+      for (size_t i = 0; i < DECIMAL_CHUNK_DIGITS; i++) {
+        *--pos = static_cast<char>('0' + chunk % 10);
+        chunk /= 10;
+      }
+    }
+    std::fill(out, pos, '0');
+    return;
+  }
+  big_integer low;
+  big_integer high = decimal_power(k - 1).divide(a, low);
+  write_decimal(high, out, k - 1);
+  write_decimal(low, out + len / 2, k - 1);
+}
+
 std::string to_string(const big_integer& a) {
   if (a == 0) {
     return "0";
   }
   big_integer temp = a;
   temp.get_absolute(true);
-  std::string prm;
 
-  while (temp.size() > 0) {
-    limb_t gt = big_integer::div_small(temp, 1000000000);
-    for (size_t i = 0; i < 9; i++) {
-      prm.append(std::to_string(gt % 10));
-      gt /= 10;
-    }
+  // Оценка сверху числа цифр: log10(2) < 0.30103.
+  size_t bits = temp.size() * LIMB_BITS;
+  size_t digits = bits * 30103 / 100000 + 1;
+  size_t k = 0;
+  while ((DECIMAL_CHUNK_DIGITS << k) < digits) {
+    k++;
   }
-  while (prm.length() > 0 && prm[prm.length() - 1] == '0') {
-    prm.pop_back();
+
+  std::string res(DECIMAL_CHUNK_DIGITS << k, '0');
+  big_integer::write_decimal(temp, res.data(), k);
+  std::deque<big_integer_reducer>& powers = decimal_powers();
+  while (powers.size() > DECIMAL_CACHED_POWERS) {
+    powers.pop_back();
   }
+  res.erase(0, res.find_first_not_of('0'));
   if (a.negate) {
-    prm.append("-");
+    res.insert(res.begin(), '-');
+  }
+  return res;
+}
+
+// Разбор строк.
+
+const size_t PARSE_THRESHOLD = 40;
+
+static int digit_value(char ch) {
+  if ('0' <= ch && ch <= '9') {
+    return ch - '0';
+  }
+  if ('a' <= ch && ch <= 'z') {
+    return ch - 'a' + 10;
+  }
+  if ('A' <= ch && ch <= 'Z') {
+    return ch - 'A' + 10;
+  }
+  return 36;
+}
+
+static void trim(limb_buffer& mag) {
+  while (!mag.empty() && mag.back() == 0) {
+    mag.pop_back();
+  }
+}
+
+// Основание - степень двойки: биты цифр укладываются в лимбы с младших разрядов за один проход.
+static limb_buffer parse_pow2(const char* first, const char* last, unsigned bits) {
+  limb_buffer res((static_cast<size_t>(last - first) * bits + LIMB_BITS - 1) / LIMB_BITS, 0);
+  size_t pos = 0;
+  for (const char* it = last; it != first;) {
+    limb_t d = digit_value(*--it);
+    res[pos / LIMB_BITS] |= d << (pos % LIMB_BITS);
+    if (pos % LIMB_BITS + bits > LIMB_BITS) {
+      res[pos / LIMB_BITS + 1] |= d >> (LIMB_BITS - pos % LIMB_BITS);
+    }
+    pos += bits;
+  }
+  trim(res);
+  return res;
+}
+
+// Разбор по chunk цифр в лимб: acc = acc * base^chunk + value.
+static limb_buffer parse_basecase(const char* first, const char* last, limb_t base, size_t chunk,
+                                          limb_t chunk_power) {
+  limb_buffer res;
+  res.reserve((static_cast<size_t>(last - first) + chunk - 1) / chunk);
+  size_t head = static_cast<size_t>(last - first) % chunk;
+  for (const char* it = first; it != last;) {
+    size_t len = (it == first && head != 0) ? head : chunk;
+    limb_t value = 0;
+    for (size_t i = 0; i < len; i++) {
+      value = value * base + digit_value(*it++);
+    }
+    limb_t carry = mul_1(res.data(), res.data(), res.size(), chunk_power);
+    carry += add_1(res.data(), res.size(), value);
+    if (carry != 0) {
+      res.push_back(carry);
+    }
+  }
+  trim(res);
+  return res;
+}
+
+// Разделяй и властвуй: младшие chunk * 2^k цифр и старшие склеиваются через powers[k] = base^{chunk * 2^k}.
+static limb_buffer parse_rec(const char* first, const char* last, limb_t base, size_t chunk,
+                                     std::vector<limb_buffer>& powers) {
+  size_t len = static_cast<size_t>(last - first);
+  if (len <= chunk * PARSE_THRESHOLD) {
+    return parse_basecase(first, last, base, chunk, powers[0][0]);
+  }
+  size_t k = 0;
+  while ((chunk << (k + 1)) < len) {
+    k++;
+  }
+  while (powers.size() <= k) {
+    const limb_buffer& p = powers.back();
+    limb_buffer sq(2 * p.size());
+    mul_mag(sq.data(), p.data(), p.size(), p.data(), p.size());
+    trim(sq);
+    powers.push_back(std::move(sq));
+  }
+  const char* mid = last - (chunk << k);
+  limb_buffer high = parse_rec(first, mid, base, chunk, powers);
+  limb_buffer low = parse_rec(mid, last, base, chunk, powers);
+  const limb_buffer& p = powers[k];
+
+  limb_buffer res(high.size() + p.size() + 1, 0);
+  mul_mag(res.data(), high.data(), high.size(), p.data(), p.size());
+  add_to(res.data(), res.size(), low.data(), low.size());
+  trim(res);
+  return res;
+}
+
+std::from_chars_result from_chars(const char* first, const char* last, big_integer& value, int base) {
+  if (base < 2 || base > 36) {
+    return {first, std::errc::invalid_argument};
+  }
+  const char* it = first;
+  bool neg = it != last && *it == '-';
+  if (neg) {
+    it++;
+  }
+  const char* digits = it;
+  while (it != last && digit_value(*it) < base) {
+    it++;
+  }
+  if (it == digits) {
+    return {first, std::errc::invalid_argument};
+  }
+
+  limb_buffer mag;
+  if (std::has_single_bit(static_cast<unsigned>(base))) {
+    mag = parse_pow2(digits, it, std::countr_zero(static_cast<unsigned>(base)));
+  } else {
+    size_t chunk = 1;
+    limb_t chunk_power = base;
+    while (chunk_power <= MAX / base) {
+      chunk_power *= base;
+      chunk++;
+    }
+    std::vector<limb_buffer> powers{{chunk_power}};
+    mag = parse_rec(digits, it, base, chunk, powers);
+  }
+
+  big_integer::limbs_t res;
+  res.resize(mag.size());
+  std::copy(mag.begin(), mag.end(), res.data());
+  value.limbs.swap(res);
+  value.negate = false;
+  if (neg) {
+    value.get_negate(true);
+  }
+  return {it, std::errc()};
+}
+
+big_integer::big_integer(std::string_view str) : negate(false) {
+  if (str.empty()) {
+    throw std::invalid_argument("Invalid input - given the empty string.");
+  }
+  const char* end = str.data() + str.size();
+  auto [ptr, ec] = from_chars(str.data(), end, *this);
+  if (ec != std::errc()) {
+    if (str.size() == 1 && (str[0] == '-' || str[0] == '+')) {
+      throw std::invalid_argument("Invalid input - no value after the sign.");
+    }
+    throw std::invalid_argument("Invalid number - unexpected char at start position");
+  }
+  if (ptr != end) {
+    throw std::invalid_argument("Invalid number - unexpected char at position " + std::to_string(ptr - str.data()));
   }
-  reverse(prm.begin(), prm.end());
-  return prm;
 }
 
 std::ostream& operator<<(std::ostream& s, const big_integer& a) {
   return s << to_string(a);
 }
+
+// Двоичный ввод-вывод. Модуль пишется и читается младшими байтами вперёд, на little-endian машинах -
+// одним копированием лимбов; знак и порядок байтов накладываются отдельным проходом по буферу.
+
+// out[0, n) = младшие n байт модуля, лимбы выше n байт должны быть нулевыми.
+static void write_magnitude(const limb_t* a, size_t an, std::byte* out, size_t n) {
+  size_t bytes = std::min(n, an * sizeof(limb_t));
+  if constexpr (std::endian::native == std::endian::little) {
+    std::memcpy(out, a, bytes);
+  } else {
+    for (size_t k = 0; k < bytes; k++) {
+      out[k] = static_cast<std::byte>(a[k / sizeof(limb_t)] >> (k % sizeof(limb_t) * 8));
+    }
+  }
+  std::fill(out + bytes, out + n, std::byte{0});
+}
+
+// Модуль из n байт; little == false - старшие байты первыми.
+static big_integer::limbs_t read_magnitude(const std::byte* in, size_t n, bool little) {
+  big_integer::limbs_t res;
+  res.resize((n + sizeof(limb_t) - 1) / sizeof(limb_t));
+  limb_t* r = res.data();
+  if (std::endian::native == std::endian::little && little) {
+    std::memcpy(r, in, n);
+  } else {
+    for (size_t k = 0; k < n; k++) {
+      std::byte b = little ? in[k] : in[n - 1 - k];
+      r[k / sizeof(limb_t)] |= static_cast<limb_t>(b) << (k % sizeof(limb_t) * 8);
+    }
+  }
+  return res;
+}
+
+size_t export_size(const big_integer& a, sign_encoding enc) {
+  size_t bits = a.bit_length();
+  // -2^k в дополнительном коде занимает k + 1 бит, как и 2^k - 1.
+  if (enc == sign_encoding::twos_complement && a < 0 && a.count_trailing_zeros() == bits - 1) {
+    bits--;
+  }
+  return bits / 8 + 1;
+}
+
+void export_bytes(const big_integer& a, contiguous_view<std::byte> out, std::endian order, sign_encoding enc) {
+  size_t n = out.size();
+  if (a.size() != 0 && export_size(a, enc) > n) {
+    throw std::invalid_argument("Buffer is too small for big_integer");
+  }
+  std::byte* p = out.data();
+  write_magnitude(a.limbs.data(), a.size(), p, n);
+  if (a.negate && enc == sign_encoding::twos_complement) {
+    // -x = ~x + 1: младшие нулевые байты не меняются, первый ненулевой отрицается, остальные инвертируются.
+    size_t k = 0;
+    while (p[k] == std::byte{0}) {
+      k++;
+    }
+    p[k] = static_cast<std::byte>(-std::to_integer<unsigned>(p[k]));
+    for (k++; k < n; k++) {
+      p[k] = ~p[k];
+    }
+  } else if (a.negate) {
+    p[n - 1] |= std::byte{0x80};
+  }
+  if (order == std::endian::big) {
+    std::reverse(p, p + n);
+  }
+}
+
+big_integer import_bytes(contiguous_view<const std::byte> in, std::endian order, sign_encoding enc) {
+  big_integer res;
+  size_t n = in.size();
+  if (n == 0) {
+    return res;
+  }
+  bool little = order == std::endian::little;
+  res.limbs = read_magnitude(in.data(), n, little);
+  std::byte top = little ? in[n - 1] : in[0];
+  if ((top & std::byte{0x80}) != std::byte{0}) {
+    limb_t* r = res.limbs.data();
+    size_t rn = res.size();
+    size_t top_bits = (n - 1) % sizeof(limb_t) * 8 + 8;
+    if (enc == sign_encoding::twos_complement) {
+      // Модуль 2^{8n} - x.
+      limb_t carry = 1;
+      for (size_t i = 0; i < rn; i++) {
+        r[i] = ~r[i] + carry;
+        carry &= r[i] == 0;
+      }
+      if (top_bits < LIMB_BITS) {
+        r[rn - 1] &= (limb_t(1) << top_bits) - 1;
+      }
+    } else {
+      r[rn - 1] &= ~(limb_t(1) << (top_bits - 1));
+    }
+    res.negate = true;
+  }
+  res.normalization();
+  return res;
+}
+
+static size_t varint_size(std::uint64_t v) {
+  size_t n = 1;
+  for (; v >= 0x80; v >>= 7) {
+    n++;
+  }
+  return n;
+}
+
+size_t serialized_size(const big_integer& a) {
+  size_t len = (a.bit_length() + 7) / 8;
+  return varint_size(2 * static_cast<std::uint64_t>(len) + (a < 0)) + len;
+}
+
+size_t serialize(const big_integer& a, contiguous_view<std::byte> out) {
+  size_t len = (a.bit_length() + 7) / 8;
+  std::uint64_t header = 2 * static_cast<std::uint64_t>(len) + a.negate;
+  size_t total = varint_size(header) + len;
+  if (out.size() < total) {
+    throw std::invalid_argument("Buffer is too small for big_integer");
+  }
+  std::byte* p = out.data();
+  for (; header >= 0x80; header >>= 7) {
+    *p++ = static_cast<std::byte>(header | 0x80);
+  }
+  *p++ = static_cast<std::byte>(header);
+  write_magnitude(a.limbs.data(), a.size(), p, len);
+  return total;
+}
+
+size_t deserialize(contiguous_view<const std::byte> in, big_integer& value) {
+  const std::byte* p = in.data();
+  size_t n = in.size();
+  std::uint64_t header = 0;
+  size_t pos = 0;
+  for (unsigned shift = 0;; shift += 7) {
+    if (pos == n || shift > 63) {
+      throw std::invalid_argument("Malformed big_integer data");
+    }
+    auto b = std::to_integer<std::uint64_t>(p[pos++]);
+    header |= (b & 0x7f) << shift;
+    if ((b & 0x80) == 0) {
+      // Лишние нулевые группы и биты за пределами 64 делают запись неоднозначной.
+      if ((b == 0 && pos > 1) || (shift > 0 && (b >> (64 - shift)) != 0)) {
+        throw std::invalid_argument("Malformed big_integer data");
+      }
+      break;
+    }
+  }
+  std::uint64_t len = header / 2;
+  bool neg = header % 2 != 0;
+  if (len > n - pos) {
+    throw std::invalid_argument("Truncated big_integer data");
+  }
+  if ((len == 0 && neg) || (len > 0 && p[pos + len - 1] == std::byte{0})) {
+    throw std::invalid_argument("Malformed big_integer data");
+  }
+  value.limbs = read_magnitude(p + pos, len, true);
+  value.negate = neg;
+  value.normalization();
+  return pos + len;
+}
@@ -1,16 +1,94 @@
 #pragma once
 
+#include "../contiguous-view/src/contiguous-view.h"
+#include "../socow-vector/src/socow-vector.h"
+
 #include <algorithm>
+#include <array>
+#include <bit>
+#include <charconv>
+#include <cstdint>
 #include <iosfwd>
+#include <stdexcept>
 #include <string>
-#include <vector>
+#include <string_view>
+#include <type_traits>
 
+// Ширина лимба выбирается при сборке: 64 бита, если компилятор умеет 128-битные произведения,
+// иначе (или при -DBIG_INTEGER_LIMB_BITS=32) 32 бита.
+#if defined(__SIZEOF_INT128__) && !(defined(BIG_INTEGER_LIMB_BITS) && BIG_INTEGER_LIMB_BITS == 32)
+using limb_t = std::uint64_t;
+__extension__ typedef unsigned __int128 dlimb_t;
+#else
 using limb_t = std::uint32_t;
 using dlimb_t = std::uint64_t;
+#endif
+
+template <typename L, typename R>
+struct big_integer_product;
+template <typename L, typename R>
+struct big_integer_sum;
+template <typename E>
+struct big_integer_shift;
+struct big_integer_eval;
+struct big_integer_batch;
+struct montgomery_context;
+
+enum class sign_encoding {
+  twos_complement,
+  sign_magnitude
+};
+
+// Память из пула текущего потока (см. big_integer_arena): блоки по классам 2^k байт переиспользуются
+// вместо malloc. Блок можно освободить в любом потоке, он попадёт в пул освобождающего.
+struct big_integer_pool {
+  static void* allocate(size_t bytes);
+  static void deallocate(void* p, size_t bytes) noexcept;
+};
+
+template <typename T>
+struct big_integer_allocator {
+  using value_type = T;
+
+  big_integer_allocator() = default;
+
+  template <typename U>
+  big_integer_allocator(const big_integer_allocator<U>&) {}
+
+  T* allocate(size_t n) {
+    return static_cast<T*>(big_integer_pool::allocate(n * sizeof(T)));
+  }
+
+  void deallocate(T* p, size_t n) {
+    big_integer_pool::deallocate(p, n * sizeof(T));
+  }
+
+  template <typename U>
+  bool operator==(const big_integer_allocator<U>&) const {
+    return true;
+  }
+};
+
+template <typename T>
+struct is_big_integer_expression : std::false_type {};
+template <typename L, typename R>
+struct is_big_integer_expression<big_integer_product<L, R>> : std::true_type {};
+template <typename L, typename R>
+struct is_big_integer_expression<big_integer_sum<L, R>> : std::true_type {};
+template <typename E>
+struct is_big_integer_expression<big_integer_shift<E>> : std::true_type {};
+
+template <typename T>
+constexpr bool is_big_integer_expression_v = is_big_integer_expression<std::remove_cvref_t<T>>::value;
 
 struct big_integer {
+  // Числа до 128 бит хранятся прямо в объекте, большие копируются за O(1) до первой записи.
+  // Буферы больших чисел берутся из пула потока, как и временные массивы внутри операций.
+  using limbs_t = socow_vector<limb_t, 16 / sizeof(limb_t), big_integer_allocator<limb_t>>;
+
   big_integer();
   big_integer(const big_integer& other);
+  big_integer(big_integer&& other) noexcept;
 
   big_integer(long long a);
   big_integer(unsigned long long a);
@@ -21,10 +99,17 @@ struct big_integer {
   big_integer(int a);
   big_integer(unsigned int a);
 
-  explicit big_integer(const std::string& str);
+  explicit big_integer(std::string_view str);
+
+  template <typename E, typename = std::enable_if_t<is_big_integer_expression_v<E>>>
+  big_integer(E e);
+
   ~big_integer() = default;
 
   big_integer& operator=(const big_integer& other);
+  big_integer& operator=(big_integer&& other) noexcept;
+  template <typename E, typename = std::enable_if_t<is_big_integer_expression_v<E>>>
+  big_integer& operator=(E rhs);
 
   big_integer& operator+=(const big_integer& rhs);
   big_integer& operator-=(const big_integer& rhs);
@@ -32,6 +117,11 @@ struct big_integer {
   big_integer& operator/=(const big_integer& rhs);
   big_integer& operator%=(const big_integer& rhs);
 
+  template <typename E, typename = std::enable_if_t<is_big_integer_expression_v<E>>>
+  big_integer& operator+=(E rhs);
+  template <typename E, typename = std::enable_if_t<is_big_integer_expression_v<E>>>
+  big_integer& operator-=(E rhs);
+
   big_integer& operator&=(const big_integer& rhs);
   big_integer& operator|=(const big_integer& rhs);
   big_integer& operator^=(const big_integer& rhs);
@@ -57,13 +147,46 @@ struct big_integer {
   friend bool operator>=(const big_integer& a, const big_integer& b);
 
   friend std::string to_string(const big_integer& a);
+  friend std::from_chars_result from_chars(const char* first, const char* last, big_integer& value, int base);
+  friend void export_bytes(const big_integer& a, contiguous_view<std::byte> out, std::endian order,
+                           sign_encoding enc);
+  friend big_integer import_bytes(contiguous_view<const std::byte> in, std::endian order, sign_encoding enc);
+  friend size_t serialize(const big_integer& a, contiguous_view<std::byte> out);
+  friend size_t deserialize(contiguous_view<const std::byte> in, big_integer& value);
+  friend void addmul(big_integer& acc, const big_integer& a, const big_integer& b);
+  friend void submul(big_integer& acc, const big_integer& a, const big_integer& b);
+  friend void addmul_limb(big_integer& acc, const big_integer& a, limb_t v);
+  friend big_integer gcd(const big_integer& a, const big_integer& b);
+  friend big_integer xgcd(const big_integer& a, const big_integer& b, big_integer& s, big_integer& t);
+  friend big_integer factorial(unsigned n);
+  friend big_integer binomial(unsigned n, unsigned k);
+  friend void batch_modmul(big_integer_batch& r, const big_integer_batch& a, const big_integer_batch& b,
+                           const montgomery_context& ctx);
 
   void get_absolute(bool normalize);
   void get_negate(bool normalize);
 
+  // Битовые запросы без сдвига всего числа. test_bit, set_bit и extract_bits для отрицательных
+  // работают с бесконечным дополнительным кодом, как &, | и >>; bit_length и popcount - с модулем.
+  // count_trailing_zeros у нуля равно 0.
+  size_t bit_length() const;
+  size_t popcount() const;
+  size_t count_trailing_zeros() const;
+  bool test_bit(size_t i) const;
+  void set_bit(size_t i, bool value = true);
+  big_integer extract_bits(size_t lo, size_t n) const;
+
 private:
+  friend struct big_integer_eval;
+  friend struct big_integer_reducer;
+  friend struct montgomery_context;
+  friend struct big_integer_batch;
+  template <size_t Bits, bool Signed>
+  friend struct fixed_integer;
+
+  // Знак и модуль: limbs - модуль без старших нулевых лимбов, у нуля negate == false.
   bool negate;
-  std::vector<limb_t> limbs;
+  limbs_t limbs;
 
   limb_t get(size_t i) const;
   size_t size() const;
@@ -73,22 +196,29 @@ private:
   void normalization();
   void nullify();
 
-  static void add_sub(big_integer& a, const big_integer& b, bool normalize, bool sub);
+  static void add_sub(big_integer& a, const big_integer& b, bool sub);
+  static void add_sub_mag(big_integer& a, const limb_t* m, size_t mn, bool sub);
+  static void add_product(big_integer& a, const big_integer& b, const big_integer& c, bool sub);
+  static void add_product_basecase(big_integer& a, const big_integer& b, const limb_t* cl, size_t cn, bool cneg,
+                                   bool sub);
   static big_integer long_divide(big_integer& a, big_integer& b, bool getRem);
 
-  limb_t get_filler() const;
-
-  static void add_sub_small(big_integer& a, const limb_t v, bool bnegate, bool normalize);
+  static void add_sub_small(big_integer& a, const limb_t v, bool sub);
   static void mul_small(big_integer& bi, const limb_t v);
   static limb_t div_small(big_integer& bi, const limb_t v);
-  static big_integer get_reminder(big_integer& buf, limb_t f);
+  static void write_decimal(big_integer& a, char* out, size_t k);
 
   void mul(big_integer& a, const big_integer& b);
+  static void sqr(big_integer& a);
 
   static big_integer div(big_integer& a, big_integer b, bool getRem);
-  static void div_difference(big_integer& a, const big_integer& b);
-  static bool div_compare(big_integer& a, big_integer& b);
-  static void shift(big_integer& a);
+
+  static void euclid_step(big_integer& a, big_integer& b, big_integer* m);
+  static void lehmer_step(big_integer& a, big_integer& b, big_integer* m);
+  static void hgcd_part(big_integer& a, big_integer& b, size_t p, big_integer* m);
+  static void hgcd(big_integer& a, big_integer& b, size_t s, big_integer* m);
+  static void gcd_reduce(big_integer& a, big_integer& b, big_integer* m);
+
   enum class Booleanic {
     AND,
     OR,
@@ -97,9 +227,306 @@ private:
   void binary_thing(big_integer& a, const big_integer& b, Booleanic op);
 };
 
-big_integer operator+(big_integer a, const big_integer& b);
-big_integer operator-(big_integer a, const big_integer& b);
-big_integer operator*(big_integer a, const big_integer& b);
+// Деление многих чисел на один и тот же делитель.
+// Нормализованный делитель и его обратное (по Ньютону) считаются один раз,
+// дальше частное и остаток получаются редукцией Барретта через умножения
+// (делители из нескольких лимбов делятся столбиком, для них это быстрее).
+struct big_integer_reducer {
+  explicit big_integer_reducer(const big_integer& divisor);
+
+  const big_integer& divisor() const;
+
+  big_integer reduce(const big_integer& a) const;
+  big_integer divide(const big_integer& a) const;
+  big_integer divide(const big_integer& a, big_integer& rem) const;
+
+private:
+  big_integer d;
+  big_integer norm;
+  big_integer mu;
+  unsigned shift;
+
+  void divrem(const big_integer& a, big_integer* quot, big_integer* rem) const;
+};
+
+// Модульная арифметика по нечётному модулю в форме Монтгомери.
+// pow - скользящее окно, pow_sec - фиксированное окно с выполнением, не зависящим от показателя.
+// Результаты лежат в [0, |modulus|).
+struct montgomery_context {
+  explicit montgomery_context(const big_integer& modulus);
+
+  const big_integer& modulus() const;
+
+  big_integer pow(const big_integer& base, const big_integer& exp) const;
+  big_integer pow_sec(const big_integer& base, const big_integer& exp) const;
+
+private:
+  friend void batch_modmul(big_integer_batch& r, const big_integer_batch& a, const big_integer_batch& b,
+                           const montgomery_context& ctx);
+
+  big_integer mod;
+  big_integer r2;
+  limb_t minv;
+
+  void to_mont(const big_integer& a, limb_t* res) const;
+  big_integer from_mont(const limb_t* a, bool secure = false) const;
+};
+
+// Пакет из size() неотрицательных чисел по limbs() лимбов в раскладке SoA: лимб i числа j лежит
+// в data()[i * stride() + j], stride() - size(), округлённый вверх до кратного восьми (лишние числа нулевые).
+// Пакетные операции идут по строкам лимбов сразу для многих чисел без ветвлений по данным,
+// с AVX-512 - по восемь чисел на инструкцию.
+struct big_integer_batch {
+  big_integer_batch(size_t count, size_t limbs);
+
+  size_t size() const;
+  size_t limbs() const;
+  size_t stride() const;
+
+  // j < size(), иначе std::out_of_range (дополнительные числа до stride() недоступны).
+  // a должно быть неотрицательным и помещаться в limbs() лимбов, иначе std::invalid_argument.
+  void set(size_t j, const big_integer& a);
+  big_integer get(size_t j) const;
+
+  limb_t* data();
+  const limb_t* data() const;
+
+private:
+  size_t count;
+  size_t len;
+  size_t lanes;
+  big_integer::limbs_t storage;
+};
+
+// Поэлементные операции над пакетами одного размера, при несовпадении размеров - std::invalid_argument.
+// batch_add и batch_sub считают по модулю β^limbs, r может совпадать с a или b. batch_mul пишет полное
+// произведение в r из 2 * limbs лимбов. batch_modmul - a * b mod m для a, b из [0, m), где m - модуль ctx
+// длины limbs лимбов; r может совпадать с a или b.
+void batch_add(big_integer_batch& r, const big_integer_batch& a, const big_integer_batch& b);
+void batch_sub(big_integer_batch& r, const big_integer_batch& a, const big_integer_batch& b);
+void batch_mul(big_integer_batch& r, const big_integer_batch& a, const big_integer_batch& b);
+void batch_modmul(big_integer_batch& r, const big_integer_batch& a, const big_integer_batch& b,
+                  const montgomery_context& ctx);
+
+// Лимбы чисел и временные буферы (делитель и частичные произведения деления, окна powmod, NTT,
+// разбор строк) берутся из пула своего потока. Пока жива арена, пул ничего не отдаёт в кучу, так что
+// серия вычислений после разогрева обходится без malloc; при выходе из внешней арены
+// пул ужимается до обычного размера. Арены вкладываются, действуют только в своём потоке.
+struct big_integer_arena {
+  big_integer_arena();
+  ~big_integer_arena();
+
+  big_integer_arena(const big_integer_arena&) = delete;
+  big_integer_arena& operator=(const big_integer_arena&) = delete;
+};
+
+// Число потоков для умножения длинных чисел, по умолчанию 1; 0 - по числу ядер. При n > 1 умножения
+// от нескольких сотен лимбов делят независимые произведения Тоома, свёртки NTT и куски несбалансированных
+// операндов между n - 1 рабочими потоками и вызывающим; деление ускоряется через свои умножения.
+// Настройка общая для всех потоков программы.
+void set_big_integer_threads(unsigned n);
+unsigned big_integer_threads();
+
+big_integer powmod(const big_integer& base, const big_integer& exp, const big_integer& mod);
+
+// НОД модулей: шаги Лемера, для длинных чисел - половинный НОД за O(M(n) log n).
+// xgcd дополнительно находит s и t с a * s + b * t = gcd(a, b); invert - обратный к a по модулю m
+// в [0, |m|), если его нет, бросает std::invalid_argument.
+big_integer gcd(const big_integer& a, const big_integer& b);
+big_integer xgcd(const big_integer& a, const big_integer& b, big_integer& s, big_integer& t);
+big_integer invert(const big_integer& a, const big_integer& m);
+
+// isqrt(n) = floor(sqrt(n)), iroot(n, k) = floor(n^{1/k}); при нечётном k отрицательное n даёт -iroot(-n, k),
+// чётный корень из отрицательного и k == 0 - std::invalid_argument. Ньютон с удвоением точности: стоимость -
+// несколько умножений и делений полной длины.
+big_integer isqrt(const big_integer& n);
+big_integer iroot(const big_integer& n, unsigned k);
+
+// Произведение множителей сбалансированным деревом: отрезок делится там, где набирается половина суммарной
+// длины, поэтому длинные умножения идут между числами близкой длины (Тоом, NTT). Пустое произведение - 1.
+big_integer product(contiguous_view<const big_integer> factors);
+
+// factorial: нечётная часть n! по prime swing, odd(n!) = odd((n/2)!)^2 * odd(swing(n)), затем сдвиг на
+// n - popcount(n). binomial(n, k) - произведение степеней простых по Куммеру, при малом k - убывающее
+// произведение, делённое на k!; при k > n - 0. Множители-лимбы перемножаются деревом.
+big_integer factorial(unsigned n);
+big_integer binomial(unsigned n, unsigned k);
+
+// a * a, a *= a тоже считается как квадрат.
+big_integer square(big_integer a);
+
+// acc += a * b, acc -= a * b и acc += a * v прямо в лимбах acc: без буфера под произведение,
+// память выделяется, только если acc растёт (и под буфер быстрого умножения на больших множителях).
+void addmul(big_integer& acc, const big_integer& a, const big_integer& b);
+void submul(big_integer& acc, const big_integer& a, const big_integer& b);
+void addmul_limb(big_integer& acc, const big_integer& a, limb_t v);
+
+// a * b, a + b, a - b и a >> k возвращают узел выражения, который неявно превращается в big_integer, и
+// дерево вычисляется целиком при этом превращении. Слагаемые суммы копятся в одном числе, произведения
+// прибавляются к нему без промежуточного числа, так что c += a * b, c - a * b, a * b + c * d обходятся
+// без временных произведений. (a + b) % m не делит, если сумма отличается от остатка не больше чем на |m|,
+// (a >> k) & mask при неотрицательной маске читает только лимбы под маской.
+// Узел хранит операнды по значению (копия числа стоит O(1), буфер общий до первой записи), поэтому
+// auto x = a * b не висит; такой x вычисляется заново при каждом использовании. Где тип выводится из
+// аргумента (std::max(a * b, c), ?: с узлами разного вида), узел нужно привести к big_integer явно.
+template <typename L, typename R>
+struct big_integer_product {
+  L a;
+  R b;
+};
+
+template <typename L, typename R>
+struct big_integer_sum {
+  L a;
+  R b;
+  bool sub;
+};
+
+template <typename E>
+struct big_integer_shift {
+  E a;
+  int bits;
+};
+
+// Операнд узла: поддерево хранится как есть, всё остальное - как big_integer (временное переносится,
+// остальное копируется). Хотя бы один операнд должен быть big_integer или узлом.
+template <typename T>
+using big_integer_operand_t =
+    std::conditional_t<is_big_integer_expression_v<T>, std::remove_cvref_t<T>, big_integer>;
+
+template <typename T>
+constexpr bool is_big_integer_operand_v =
+    std::is_same_v<std::remove_cvref_t<T>, big_integer> || is_big_integer_expression_v<T>;
+
+template <typename A, typename B>
+constexpr bool big_integer_operands_v = (is_big_integer_operand_v<A> || is_big_integer_operand_v<B>) &&
+                                        std::is_convertible_v<A, big_integer> && std::is_convertible_v<B, big_integer>;
+
+// Вычисление узлов; нешаблонные части - в big_integer.cpp. Узел владеет операндами, поэтому результат
+// можно писать прямо в dst, даже если dst - один из исходных операндов.
+struct big_integer_eval {
+  static void assign(big_integer& dst, big_integer&& a) {
+    dst = std::move(a);
+  }
+
+  template <typename L, typename R>
+  static void assign(big_integer& dst, big_integer_product<L, R>&& e) {
+    assign(dst, std::move(e.a));
+    multiply(dst, value(std::move(e.b)));
+  }
+
+  template <typename L, typename R>
+  static void assign(big_integer& dst, big_integer_sum<L, R>&& e) {
+    assign(dst, std::move(e.a));
+    add(dst, std::move(e.b), e.sub);
+  }
+
+  // a * b ± c = ±(c ± a * b): произведение прибавляется прямо к c.
+  template <typename L, typename R, typename C>
+  static void assign(big_integer& dst, big_integer_sum<big_integer_product<L, R>, C>&& e) {
+    assign(dst, std::move(e.b));
+    add(dst, std::move(e.a), e.sub);
+    if (e.sub) {
+      dst.get_negate(true);
+    }
+  }
+
+  template <typename E>
+  static void assign(big_integer& dst, big_integer_shift<E>&& e) {
+    dst = shift(value(std::move(e.a)), e.bits);
+  }
+
+  static big_integer&& value(big_integer&& a) {
+    return std::move(a);
+  }
+
+  template <typename E, typename = std::enable_if_t<is_big_integer_expression_v<E>>>
+  static big_integer value(E&& e) {
+    big_integer res;
+    assign(res, std::move(e));
+    return res;
+  }
+
+  // acc += e (sub: acc -= e), слагаемые суммы прибавляются к acc по одному.
+  template <typename L, typename R>
+  static void add(big_integer& acc, big_integer_sum<L, R>&& e, bool sub) {
+    add(acc, std::move(e.a), sub);
+    add(acc, std::move(e.b), sub != e.sub);
+  }
+
+  template <typename L, typename R>
+  static void add(big_integer& acc, big_integer_product<L, R>&& e, bool sub) {
+    add_product(acc, value(std::move(e.a)), value(std::move(e.b)), sub);
+  }
+
+  template <typename E>
+  static void add(big_integer& acc, big_integer_shift<E>&& e, bool sub) {
+    add(acc, value(std::move(e)), sub);
+  }
+
+  static void add(big_integer& acc, big_integer&& a, bool sub);
+  static void add_product(big_integer& acc, const big_integer& a, const big_integer& b, bool sub);
+  static void multiply(big_integer& a, const big_integer& b);
+  static big_integer shift(const big_integer& a, int bits);
+  static big_integer shift_and(const big_integer& a, int bits, big_integer mask);
+  static big_integer reduce(big_integer a, const big_integer& m);
+};
+
+template <typename E, typename>
+big_integer::big_integer(E e) : negate(false) {
+  big_integer_eval::assign(*this, std::move(e));
+}
+
+template <typename E, typename>
+big_integer& big_integer::operator=(E rhs) {
+  big_integer_eval::assign(*this, std::move(rhs));
+  return *this;
+}
+
+template <typename E, typename>
+big_integer& big_integer::operator+=(E rhs) {
+  big_integer_eval::add(*this, std::move(rhs), false);
+  return *this;
+}
+
+template <typename E, typename>
+big_integer& big_integer::operator-=(E rhs) {
+  big_integer_eval::add(*this, std::move(rhs), true);
+  return *this;
+}
+
+template <typename A, typename B, typename = std::enable_if_t<big_integer_operands_v<A, B>>>
+big_integer_product<big_integer_operand_t<A>, big_integer_operand_t<B>> operator*(A&& a, B&& b) {
+  return {std::forward<A>(a), std::forward<B>(b)};
+}
+
+template <typename A, typename B, typename = std::enable_if_t<big_integer_operands_v<A, B>>>
+big_integer_sum<big_integer_operand_t<A>, big_integer_operand_t<B>> operator+(A&& a, B&& b) {
+  return {std::forward<A>(a), std::forward<B>(b), false};
+}
+
+template <typename A, typename B, typename = std::enable_if_t<big_integer_operands_v<A, B>>>
+big_integer_sum<big_integer_operand_t<A>, big_integer_operand_t<B>> operator-(A&& a, B&& b) {
+  return {std::forward<A>(a), std::forward<B>(b), true};
+}
+
+template <typename A, typename = std::enable_if_t<is_big_integer_operand_v<A>>>
+big_integer_shift<big_integer_operand_t<A>> operator>>(A&& a, int b) {
+  return {std::forward<A>(a), b};
+}
+
+template <typename E, typename = std::enable_if_t<is_big_integer_expression_v<E>>>
+big_integer operator-(E e) {
+  big_integer res(std::move(e));
+  res.get_negate(true);
+  return res;
+}
+
+template <typename E, typename = std::enable_if_t<is_big_integer_expression_v<E>>>
+big_integer operator~(E e) {
+  return ~big_integer(std::move(e));
+}
+
 big_integer operator/(big_integer a, const big_integer& b);
 big_integer operator%(big_integer a, const big_integer& b);
 
@@ -107,8 +534,31 @@ big_integer operator&(big_integer a, const big_integer& b);
 big_integer operator|(big_integer a, const big_integer& b);
 big_integer operator^(big_integer a, const big_integer& b);
 
+big_integer operator&(const big_integer& a, big_integer&& b);
+big_integer operator|(const big_integer& a, big_integer&& b);
+big_integer operator^(const big_integer& a, big_integer&& b);
+
 big_integer operator<<(big_integer a, int b);
-big_integer operator>>(big_integer a, int b);
+
+template <typename L, typename R>
+big_integer operator%(big_integer_sum<L, R> e, const big_integer& m) {
+  return big_integer_eval::reduce(big_integer_eval::value(std::move(e)), m);
+}
+
+template <typename E>
+big_integer operator&(big_integer_shift<E> e, big_integer mask) {
+  return big_integer_eval::shift_and(big_integer_eval::value(std::move(e.a)), e.bits, std::move(mask));
+}
+
+template <typename E>
+big_integer operator&(big_integer mask, big_integer_shift<E> e) {
+  return std::move(e) & std::move(mask);
+}
+
+template <typename E, typename F>
+big_integer operator&(big_integer_shift<E> e, big_integer_shift<F> f) {
+  return std::move(e) & big_integer(std::move(f));
+}
 
 bool operator==(const big_integer& a, const big_integer& b);
 bool operator!=(const big_integer& a, const big_integer& b);
@@ -118,4 +568,392 @@ bool operator<=(const big_integer& a, const big_integer& b);
 bool operator>=(const big_integer& a, const big_integer& b);
 
 std::string to_string(const big_integer& a);
+std::from_chars_result from_chars(const char* first, const char* last, big_integer& value, int base = 10);
 std::ostream& operator<<(std::ostream& s, const big_integer& a);
+
+// Двоичное представление ровно в out.size() байт без перевода в текст. twos_complement - дополнительный
+// код, расширенный знаком до длины буфера; sign_magnitude - модуль, старший бит старшего байта - знак.
+// export_size - минимальная длина, в которую помещается a (у нуля 1). Не помещается - std::invalid_argument.
+// import_bytes читает тот же формат, пустой буфер - ноль.
+size_t export_size(const big_integer& a, sign_encoding enc);
+void export_bytes(const big_integer& a, contiguous_view<std::byte> out, std::endian order = std::endian::little,
+                  sign_encoding enc = sign_encoding::twos_complement);
+big_integer import_bytes(contiguous_view<const std::byte> in, std::endian order = std::endian::little,
+                         sign_encoding enc = sign_encoding::twos_complement);
+
+// Компактная запись для хранения и отображения в память: LEB128 от 2 * len + (a < 0), где len - длина
+// модуля в байтах, затем модуль little-endian без старших нулевых байтов. Запись у числа одна.
+// serialize пишет в начало out и возвращает число записанных байт, deserialize читает число из начала in
+// и возвращает число прочитанных байт. Нехватка места, обрыв и неканоническая запись - std::invalid_argument.
+size_t serialized_size(const big_integer& a);
+size_t serialize(const big_integer& a, contiguous_view<std::byte> out);
+size_t deserialize(contiguous_view<const std::byte> in, big_integer& value);
+
+// Целое фиксированной ширины Bits (кратной 64) в дополнительном коде, лимбы лежат в std::array.
+// Сложение, вычитание и умножение идут по модулю 2^Bits, как у встроенных типов; деление с остатком,
+// сдвиги и побитовые операции - с семантикой big_integer в пределах ширины. Все операции constexpr,
+// циклы с известной при компиляции длиной. Из big_integer берутся младшие Bits бит (с учётом знака),
+// преобразования в обе стороны - копирование лимбов.
+template <size_t Bits, bool Signed = true>
+struct fixed_integer {
+  static_assert(Bits > 0 && Bits % 64 == 0, "fixed_integer width must be a positive multiple of 64");
+
+  static constexpr size_t LIMB_WIDTH = sizeof(limb_t) * 8;
+  static constexpr size_t LIMBS = Bits / LIMB_WIDTH;
+
+  constexpr fixed_integer() : limbs() {}
+
+  template <typename T, typename = std::enable_if_t<std::is_integral_v<T> && sizeof(T) <= sizeof(long long)>>
+  constexpr fixed_integer(T a) : limbs() {
+    // Знаковые расширяются до 64 бит знаком, дальше заполняются копиями знакового бита.
+    using W = std::conditional_t<std::is_signed_v<T>, long long, unsigned long long>;
+    auto u = static_cast<unsigned long long>(static_cast<W>(a));
+    limb_t fill = std::is_signed_v<T> && static_cast<W>(a) < 0 ? ~limb_t(0) : 0;
+    for (size_t i = 0; i < LIMBS; i++) {
+      limbs[i] = i * LIMB_WIDTH < 64 ? static_cast<limb_t>(u >> (i * LIMB_WIDTH)) : fill;
+    }
+  }
+
+  explicit fixed_integer(const big_integer& a);
+  explicit operator big_integer() const;
+
+  constexpr bool is_negative() const {
+    return Signed && (limbs[LIMBS - 1] >> (LIMB_WIDTH - 1)) != 0;
+  }
+
+  constexpr fixed_integer& operator+=(const fixed_integer& rhs) {
+    limb_t carry = 0;
+    for (size_t i = 0; i < LIMBS; i++) {
+      dlimb_t s = static_cast<dlimb_t>(limbs[i]) + rhs.limbs[i] + carry;
+      limbs[i] = static_cast<limb_t>(s);
+      carry = static_cast<limb_t>(s >> LIMB_WIDTH);
+    }
+    return *this;
+  }
+
+  constexpr fixed_integer& operator-=(const fixed_integer& rhs) {
+    limb_t borrow = 0;
+    for (size_t i = 0; i < LIMBS; i++) {
+      dlimb_t d = static_cast<dlimb_t>(limbs[i]) - rhs.limbs[i] - borrow;
+      limbs[i] = static_cast<limb_t>(d);
+      borrow = static_cast<limb_t>(d >> (2 * LIMB_WIDTH - 1));
+    }
+    return *this;
+  }
+
+  // Школьное умножение, произведения выше Bits бит не считаются.
+  constexpr fixed_integer& operator*=(const fixed_integer& rhs) {
+    std::array<limb_t, LIMBS> r{};
+    for (size_t i = 0; i < LIMBS; i++) {
+      limb_t carry = 0;
+      for (size_t j = 0; i + j < LIMBS; j++) {
+        dlimb_t t = static_cast<dlimb_t>(limbs[i]) * rhs.limbs[j] + r[i + j] + carry;
+        r[i + j] = static_cast<limb_t>(t);
+        carry = static_cast<limb_t>(t >> LIMB_WIDTH);
+      }
+    }
+    limbs = r;
+    return *this;
+  }
+
+  constexpr fixed_integer& operator/=(const fixed_integer& rhs) {
+    fixed_integer rem = *this;
+    divide(rem, rhs, *this);
+    return *this;
+  }
+
+  constexpr fixed_integer& operator%=(const fixed_integer& rhs) {
+    fixed_integer quot;
+    divide(*this, rhs, quot);
+    return *this;
+  }
+
+  constexpr fixed_integer& operator&=(const fixed_integer& rhs) {
+    for (size_t i = 0; i < LIMBS; i++) {
+      limbs[i] &= rhs.limbs[i];
+    }
+    return *this;
+  }
+
+  constexpr fixed_integer& operator|=(const fixed_integer& rhs) {
+    for (size_t i = 0; i < LIMBS; i++) {
+      limbs[i] |= rhs.limbs[i];
+    }
+    return *this;
+  }
+
+  constexpr fixed_integer& operator^=(const fixed_integer& rhs) {
+    for (size_t i = 0; i < LIMBS; i++) {
+      limbs[i] ^= rhs.limbs[i];
+    }
+    return *this;
+  }
+
+  constexpr fixed_integer& operator<<=(int rhs) {
+    size_t k = static_cast<size_t>(rhs) / LIMB_WIDTH;
+    size_t s = static_cast<size_t>(rhs) % LIMB_WIDTH;
+    for (size_t i = LIMBS; i-- > 0;) {
+      limb_t hi = i >= k ? limbs[i - k] : 0;
+      limb_t lo = i >= k + 1 ? limbs[i - k - 1] : 0;
+      limbs[i] = s == 0 ? hi : (hi << s) | (lo >> (LIMB_WIDTH - s));
+    }
+    return *this;
+  }
+
+  // Для отрицательных знаковых - арифметический сдвиг (округление вниз), как у big_integer.
+  constexpr fixed_integer& operator>>=(int rhs) {
+    limb_t fill = is_negative() ? ~limb_t(0) : 0;
+    size_t k = static_cast<size_t>(rhs) / LIMB_WIDTH;
+    size_t s = static_cast<size_t>(rhs) % LIMB_WIDTH;
+    for (size_t i = 0; i < LIMBS; i++) {
+      limb_t lo = i + k < LIMBS ? limbs[i + k] : fill;
+      limb_t hi = i + k + 1 < LIMBS ? limbs[i + k + 1] : fill;
+      limbs[i] = s == 0 ? lo : (lo >> s) | (hi << (LIMB_WIDTH - s));
+    }
+    return *this;
+  }
+
+  constexpr fixed_integer operator+() const {
+    return *this;
+  }
+
+  constexpr fixed_integer operator-() const {
+    fixed_integer res;
+    res -= *this;
+    return res;
+  }
+
+  constexpr fixed_integer operator~() const {
+    fixed_integer res = *this;
+    for (limb_t& l : res.limbs) {
+      l = ~l;
+    }
+    return res;
+  }
+
+  constexpr fixed_integer& operator++() {
+    return *this += 1;
+  }
+
+  constexpr fixed_integer operator++(int) {
+    fixed_integer res = *this;
+    ++*this;
+    return res;
+  }
+
+  constexpr fixed_integer& operator--() {
+    return *this -= 1;
+  }
+
+  constexpr fixed_integer operator--(int) {
+    fixed_integer res = *this;
+    --*this;
+    return res;
+  }
+
+  friend constexpr fixed_integer operator+(fixed_integer a, const fixed_integer& b) {
+    return a += b;
+  }
+
+  friend constexpr fixed_integer operator-(fixed_integer a, const fixed_integer& b) {
+    return a -= b;
+  }
+
+  friend constexpr fixed_integer operator*(fixed_integer a, const fixed_integer& b) {
+    return a *= b;
+  }
+
+  friend constexpr fixed_integer operator/(fixed_integer a, const fixed_integer& b) {
+    return a /= b;
+  }
+
+  friend constexpr fixed_integer operator%(fixed_integer a, const fixed_integer& b) {
+    return a %= b;
+  }
+
+  friend constexpr fixed_integer operator&(fixed_integer a, const fixed_integer& b) {
+    return a &= b;
+  }
+
+  friend constexpr fixed_integer operator|(fixed_integer a, const fixed_integer& b) {
+    return a |= b;
+  }
+
+  friend constexpr fixed_integer operator^(fixed_integer a, const fixed_integer& b) {
+    return a ^= b;
+  }
+
+  friend constexpr fixed_integer operator<<(fixed_integer a, int b) {
+    return a <<= b;
+  }
+
+  friend constexpr fixed_integer operator>>(fixed_integer a, int b) {
+    return a >>= b;
+  }
+
+  friend constexpr bool operator==(const fixed_integer& a, const fixed_integer& b) {
+    return a.limbs == b.limbs;
+  }
+
+  friend constexpr bool operator!=(const fixed_integer& a, const fixed_integer& b) {
+    return !(a == b);
+  }
+
+  friend constexpr bool operator<(const fixed_integer& a, const fixed_integer& b) {
+    return compare(a, b) < 0;
+  }
+
+  friend constexpr bool operator>(const fixed_integer& a, const fixed_integer& b) {
+    return compare(a, b) > 0;
+  }
+
+  friend constexpr bool operator<=(const fixed_integer& a, const fixed_integer& b) {
+    return compare(a, b) <= 0;
+  }
+
+  friend constexpr bool operator>=(const fixed_integer& a, const fixed_integer& b) {
+    return compare(a, b) >= 0;
+  }
+
+private:
+  std::array<limb_t, LIMBS> limbs;
+
+  // У знакового старший бит инвертируется, дальше сравнение как у беззнаковых.
+  static constexpr int compare(const fixed_integer& a, const fixed_integer& b) {
+    const limb_t sign = Signed ? limb_t(1) << (LIMB_WIDTH - 1) : 0;
+    for (size_t i = LIMBS; i-- > 0;) {
+      limb_t x = i == LIMBS - 1 ? a.limbs[i] ^ sign : a.limbs[i];
+      limb_t y = i == LIMBS - 1 ? b.limbs[i] ^ sign : b.limbs[i];
+      if (x != y) {
+        return x < y ? -1 : 1;
+      }
+    }
+    return 0;
+  }
+
+  // Деление с усечением к нулю: a -> a % b (знак делимого), q = a / b. Через модули по алгоритму D Кнута.
+  static constexpr void divide(fixed_integer& a, fixed_integer b, fixed_integer& q) {
+    bool a_neg = a.is_negative();
+    bool q_neg = a_neg != b.is_negative();
+    if (a_neg) {
+      a = -a;
+    }
+    if (b.is_negative()) {
+      b = -b;
+    }
+    divide_mag(a.limbs, b.limbs, q.limbs);
+    if (q_neg) {
+      q = -q;
+    }
+    if (a_neg) {
+      a = -a;
+    }
+  }
+
+  static constexpr void divide_mag(std::array<limb_t, LIMBS>& a, const std::array<limb_t, LIMBS>& b,
+                                   std::array<limb_t, LIMBS>& q) {
+    size_t n = LIMBS;
+    while (n > 0 && b[n - 1] == 0) {
+      n--;
+    }
+    if (n == 0) {
+      throw std::invalid_argument("Division by zero");
+    }
+    q = {};
+    if (n == 1) {
+      dlimb_t rem = 0;
+      for (size_t i = LIMBS; i-- > 0;) {
+        dlimb_t cur = (rem << LIMB_WIDTH) | a[i];
+        q[i] = static_cast<limb_t>(cur / b[0]);
+        rem = cur % b[0];
+      }
+      a = {};
+      a[0] = static_cast<limb_t>(rem);
+      return;
+    }
+
+    // Нормализация: старший бит делителя v единичный, u - делимое со сдвигом и лишним лимбом.
+    unsigned s = std::countl_zero(b[n - 1]);
+    std::array<limb_t, LIMBS> v{};
+    std::array<limb_t, LIMBS + 1> u{};
+    for (size_t i = n; i-- > 0;) {
+      v[i] = (b[i] << s) | (s != 0 && i > 0 ? b[i - 1] >> (LIMB_WIDTH - s) : 0);
+    }
+    u[LIMBS] = s != 0 ? a[LIMBS - 1] >> (LIMB_WIDTH - s) : 0;
+    for (size_t i = LIMBS; i-- > 0;) {
+      u[i] = (a[i] << s) | (s != 0 && i > 0 ? a[i - 1] >> (LIMB_WIDTH - s) : 0);
+    }
+
+    for (size_t j = LIMBS - n + 1; j-- > 0;) {
+      dlimb_t num = (static_cast<dlimb_t>(u[j + n]) << LIMB_WIDTH) | u[j + n - 1];
+      dlimb_t qhat = num / v[n - 1];
+      dlimb_t rhat = num % v[n - 1];
+      while ((qhat >> LIMB_WIDTH) != 0 || qhat * v[n - 2] > ((rhat << LIMB_WIDTH) | u[j + n - 2])) {
+        qhat--;
+        rhat += v[n - 1];
+        if ((rhat >> LIMB_WIDTH) != 0) {
+          break;
+        }
+      }
+      // u[j, j + n] -= qhat * v, при заёме частное на единицу меньше.
+      limb_t carry = 0;
+      limb_t borrow = 0;
+      for (size_t i = 0; i < n; i++) {
+        dlimb_t p = qhat * v[i] + carry;
+        carry = static_cast<limb_t>(p >> LIMB_WIDTH);
+        dlimb_t d = static_cast<dlimb_t>(u[i + j]) - static_cast<limb_t>(p) - borrow;
+        u[i + j] = static_cast<limb_t>(d);
+        borrow = static_cast<limb_t>(d >> (2 * LIMB_WIDTH - 1));
+      }
+      dlimb_t d = static_cast<dlimb_t>(u[j + n]) - carry - borrow;
+      u[j + n] = static_cast<limb_t>(d);
+      if ((d >> (2 * LIMB_WIDTH - 1)) != 0) {
+        qhat--;
+        limb_t c = 0;
+        for (size_t i = 0; i < n; i++) {
+          dlimb_t t = static_cast<dlimb_t>(u[i + j]) + v[i] + c;
+          u[i + j] = static_cast<limb_t>(t);
+          c = static_cast<limb_t>(t >> LIMB_WIDTH);
+        }
+        u[j + n] += c;
+      }
+      q[j] = static_cast<limb_t>(qhat);
+    }
+
+    a = {};
+    for (size_t i = 0; i < n; i++) {
+      a[i] = (u[i] >> s) | (s != 0 ? u[i + 1] << (LIMB_WIDTH - s) : 0);
+    }
+  }
+};
+
+template <size_t Bits, bool Signed>
+fixed_integer<Bits, Signed>::fixed_integer(const big_integer& a) : limbs() {
+  const big_integer::limbs_t& src = a.limbs;
+  std::copy(src.begin(), src.begin() + std::min(src.size(), LIMBS), limbs.begin());
+  if (a.negate) {
+    *this = -*this;
+  }
+}
+
+template <size_t Bits, bool Signed>
+fixed_integer<Bits, Signed>::operator big_integer() const {
+  bool neg = is_negative();
+  fixed_integer m = neg ? -*this : *this;
+  big_integer res;
+  res.limbs.resize(LIMBS);
+  std::copy(m.limbs.begin(), m.limbs.end(), res.limbs.data());
+  res.negate = neg;
+  res.normalization();
+  return res;
+}
+
+template <size_t Bits, bool Signed>
+std::string to_string(const fixed_integer<Bits, Signed>& a) {
+  return to_string(static_cast<big_integer>(a));
+}
+
+template <size_t Bits, bool Signed>
+std::ostream& operator<<(std::ostream& s, const fixed_integer<Bits, Signed>& a) {
+  return s << static_cast<big_integer>(a);
+}
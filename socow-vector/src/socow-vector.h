@@ -1,10 +1,14 @@
 #pragma once
 
 #include <algorithm>
+#include <atomic>
+#include <cstddef>
 #include <memory>
+#include <type_traits>
 #include <utility>
 
-template <typename T, size_t SMALL_SIZE>
+// Allocator - без состояния: буферы выделяются и освобождаются его экземплярами по умолчанию.
+template <typename T, size_t SMALL_SIZE, typename Allocator = std::allocator<T>>
 class socow_vector {
 public:
   using value_type = T;
@@ -21,12 +25,31 @@ public:
     *this = other;
   }
 
-  socow_vector(const socow_vector& other, size_t capacity) : isLarge(true) {
-    socow_vector tmp(capacity);
+  socow_vector(const socow_vector& other, size_t capacity) : socow_vector(capacity) {
     std::uninitialized_copy_n(other.data(), std::min(capacity, other.size()),
-                              (tmp.isLarge ? tmp.d_data->data : tmp.static_buffer));
-    tmp._size = other.size();
-    swap(tmp);
+                              (isLarge ? d_data->data : static_buffer));
+    _size = std::min(capacity, other.size());
+  }
+
+  socow_vector(socow_vector&& other) noexcept(std::is_nothrow_move_constructible_v<T>) {
+    if (other.isLarge) {
+      d_data = other.d_data;
+      isLarge = true;
+      _size = other._size;
+      other.isLarge = false;
+      other._size = 0;
+    } else {
+      std::uninitialized_move_n(other.static_buffer, other.size(), static_buffer);
+      _size = other.size();
+    }
+  }
+
+  socow_vector& operator=(socow_vector&& other) noexcept(std::is_nothrow_move_constructible_v<T>) {
+    if (this != &other) {
+      this->~socow_vector();
+      new (this) socow_vector(std::move(other));
+    }
+    return *this;
   }
 
   socow_vector& operator=(const socow_vector& other) {
@@ -44,10 +67,9 @@ public:
             d_data = x;
             throw;
           }
-          if (--x->ref_count == 0) {
+          if (x->ref_count.fetch_sub(1, std::memory_order_acq_rel) == 1) {
             clear_buffer(x->data, size());
-            x->~dynamic_buffer();
-            operator delete(x);
+            free_buffer(x);
           }
         }
       } else {
@@ -168,6 +190,18 @@ public:
     }
   }
 
+  void resize(size_t new_size, const T& val = T()) {
+    if (new_size <= size()) {
+      erase(std::as_const(*this).begin() + new_size, std::as_const(*this).end());
+      return;
+    }
+    if (shared() || new_size > capacity()) {
+      *this = socow_vector(*this, new_size > capacity() ? std::max(new_size, capacity() * 2) : capacity());
+    }
+    std::uninitialized_fill(data() + size(), data() + new_size, val);
+    _size = new_size;
+  }
+
   void shrink_to_fit() {
     if (capacity() != SMALL_SIZE && size() != capacity()) {
       if (size() > SMALL_SIZE) {
@@ -301,6 +335,14 @@ public:
     return begin() + ix;
   }
 
+  friend bool operator==(const socow_vector& a, const socow_vector& b) {
+    return a.size() == b.size() && std::equal(a.begin(), a.end(), b.begin());
+  }
+
+  friend bool operator!=(const socow_vector& a, const socow_vector& b) {
+    return !(a == b);
+  }
+
 private:
   size_t _size{0};
   bool isLarge = false;
@@ -309,7 +351,7 @@ private:
     dynamic_buffer(std::size_t capacity) : _capacity(capacity) {}
 
     size_t _capacity = 0;
-    size_t ref_count = 1;
+    std::atomic<size_t> ref_count{1};
     T data[0];
   };
 
@@ -327,40 +369,51 @@ private:
     isLarge = true;
   }
 
+  using byte_allocator = typename std::allocator_traits<Allocator>::template rebind_alloc<std::byte>;
+
+  static size_t buffer_bytes(size_t cap) {
+    return sizeof(dynamic_buffer) + sizeof(value_type) * cap;
+  }
+
   dynamic_buffer* allocate_buffer(size_t cap) {
-    dynamic_buffer* new_dyn_buff =
-        static_cast<dynamic_buffer*>(operator new(sizeof(dynamic_buffer) + sizeof(value_type) * cap));
-    new (new_dyn_buff) dynamic_buffer{cap};
-    return new_dyn_buff;
+    byte_allocator alloc;
+    void* raw = std::allocator_traits<byte_allocator>::allocate(alloc, buffer_bytes(cap));
+    return new (raw) dynamic_buffer{cap};
+  }
+
+  static void free_buffer(dynamic_buffer* buf) {
+    size_t bytes = buffer_bytes(buf->_capacity);
+    buf->~dynamic_buffer();
+    byte_allocator alloc;
+    std::allocator_traits<byte_allocator>::deallocate(alloc, reinterpret_cast<std::byte*>(buf), bytes);
   }
 
   bool shared() {
-    return isLarge && d_data->ref_count > 1;
+    return isLarge && d_data->ref_count.load(std::memory_order_acquire) > 1;
   }
 
   void add_ref() {
     if (!d_data) {
       return;
     }
-    ++d_data->ref_count;
+    d_data->ref_count.fetch_add(1, std::memory_order_relaxed);
   }
 
   void release_ref() {
     if (d_data == nullptr) {
       return;
     }
-    if (--d_data->ref_count == 0) {
-      d_data->_capacity = 0;
+    if (d_data->ref_count.fetch_sub(1, std::memory_order_acq_rel) == 1) {
       clear_buffer(d_data->data, size());
       _size = 0;
 
-      operator delete(d_data);
+      free_buffer(d_data);
       d_data = nullptr;
     }
   }
 
   void unshare() {
-    if (d_data->ref_count == 1) {
+    if (d_data->ref_count.load(std::memory_order_acquire) == 1) {
       return;
     }
     socow_vector temp(*this, d_data->_capacity);